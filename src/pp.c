@@ -1,1546 +1,5693 @@
-#define _GNU_SOURCE
-#define _FILE_OFFSET_BITS 64
-#define __USE_MINGW_ANSI_STDIO 1
-
-#include <stdio.h>
-#include <stdint.h>
-#include <stdlib.h>
-#include <string.h>
-#include <fcntl.h>
-#include <time.h>
-#include <errno.h>
-#include <getopt.h>
-#include <ctype.h>
-#include <signal.h>
-
-#include "mpz_int128.h"
-
-/**
- * Name........: princeprocessor (pp)
- * Description.: Standalone password candidate generator using the PRINCE algorithm
- * Version.....: 0.22
- * Authors.....: Jens Steube <jens.steube@gmail.com>
- *               Steve Thomas (Sc00bz)
- *               magnum <john.magnum@hushmail.com>
- * License.....: MIT
- */
-
-#define IN_LEN_MIN    1
-#define IN_LEN_MAX    32
-#define OUT_LEN_MAX   32 /* Limited by (u32)(1 << pw_len - 1) */
-#define PW_MIN        1
-#define PW_MAX        16
-#define ELEM_CNT_MIN  1
-#define ELEM_CNT_MAX  8
-#define WL_DIST_LEN   0
-#define WL_MAX        10000000
-#define CASE_PERMUTE  0
-#define DUPE_CHECK    1
-#define SAVE_POS      1
-#define SAVE_FILE     "pp.save"
-
-#define VERSION_BIN   22
-
-#define ALLOC_NEW_ELEMS  0x40000
-#define ALLOC_NEW_CHAINS 0x10
-#define ALLOC_NEW_DUPES  0x100000
-
-#define ENTRY_END_HASH   0xFFFFFFFF
-
-#define MIN(a,b) (((a) < (b)) ? (a) : (b))
-#define MAX(a,b) (((a) > (b)) ? (a) : (b))
-
-typedef uint8_t  u8;
-typedef uint16_t u16;
-typedef uint32_t u32;
-typedef uint64_t u64;
-
-typedef struct
-{
-  int len;
-  u64 cnt;
-
-} pw_order_t;
-
-typedef struct
-{
-  u8   *buf;
-
-} elem_t;
-
-typedef struct
-{
-  u8   *buf;
-  int   cnt;
-
-  mpz_t ks_cnt;
-  mpz_t ks_pos;
-
-} chain_t;
-
-typedef struct
-{
-  u32 next;
-
-  char *element;
-
-} uniq_data_t;
-
-typedef struct
-{
-  u32 index;
-  u32 alloc;
-
-  u32 *hash;
-  u32 hash_mask;
-
-  uniq_data_t *data;
-
-} uniq_t;
-
-typedef struct
-{
-  elem_t  *elems_buf;
-  u64      elems_cnt;
-  u64      elems_alloc;
-
-  chain_t *chains_buf;
-  int      chains_cnt;
-  int      chains_pos;
-  int      chains_alloc;
-
-  u64      cur_chain_ks_poses[OUT_LEN_MAX];
-
-  uniq_t  *uniq;
-
-} db_entry_t;
-
-typedef struct
-{
-  FILE *fp;
-
-  char  buf[BUFSIZ];
-  int   len;
-
-} out_t;
-
-/**
- * Default word-length distribution, calculated out of first 1,000,000 entries of rockyou.txt
- */
-
-#define DEF_WORDLEN_DIST_CNT 25
-
-static u64 DEF_WORDLEN_DIST[DEF_WORDLEN_DIST_CNT] =
-{
-  0,
-  15,
-  56,
-  350,
-  3315,
-  43721,
-  276252,
-  201748,
-  226412,
-  119885,
-  75075,
-  26323,
-  13373,
-  6353,
-  3540,
-  1877,
-  972,
-  311,
-  151,
-  81,
-  66,
-  21,
-  16,
-  13,
-  13
-};
-
-/* Losely based on rockyou-with-dupes */
-static const u32 DEF_HASH_LOG_SIZE[33] =
-{  0,
-   8, 12, 16, 20, 24, 24, 24, 24,
-  24, 24, 23, 22, 21, 20, 19, 18,
-  17, 16, 16, 16, 16, 16, 16, 16,
-  16, 16, 16, 16, 16, 16, 16, 16
-};
-
-static const char *USAGE_MINI[] =
-{
-  "Usage: %s [options] [<] wordlist",
-  "",
-  "Try --help for more help.",
-  NULL
-};
-
-static const char *USAGE_BIG[] =
-{
-  "Usage: %s [options] [<] wordlist",
-  "",
-  "* Startup:",
-  "",
-  "  -V,  --version             Print version",
-  "  -h,  --help                Print help",
-  "",
-  "* Misc:",
-  "",
-  "       --keyspace            Calculate number of combinations",
-  "",
-  "* Optimization:",
-  "",
-  "       --pw-min=NUM          Print candidate if length is greater than NUM",
-  "       --pw-max=NUM          Print candidate if length is smaller than NUM",
-  "       --elem-cnt-min=NUM    Minimum number of elements per chain",
-  "       --elem-cnt-max=NUM    Maximum number of elements per chain",
-  "       --wl-dist-len         Calculate output length distribution from wordlist",
-  "       --wl-max=NUM          Load only NUM words from input wordlist or use 0 to disable",
-  "  -c,  --dupe-check-disable  Disable dupes check for faster initial load",
-  "       --save-pos-disable    Save the position for later resume with -s",
-  "",
-  "* Resources:",
-  "",
-  "  -s,  --skip=NUM            Skip NUM passwords from start (for distributed)",
-  "  -l,  --limit=NUM           Limit output to NUM passwords (for distributed)",
-  "",
-  "* Files:",
-  "",
-  "  -o,  --output-file=FILE    Output-file",
-  "",
-  "* Amplifier:",
-  "",
-  "       --case-permute        For each word in the wordlist that begins with a letter",
-  "                             generate a word with the opposite case of the first letter",
-  "",
-  NULL
-};
-
-static void *mem_alloc (const size_t size)
-{
-  void *res = malloc (size);
-
-  if (res == NULL)
-  {
-    fprintf (stderr, "malloc: %s\n", strerror (ENOMEM));
-
-    exit (-1);
-  }
-
-  return res;
-}
-
-static void *malloc_tiny (const size_t size)
-{
-  #ifdef DEBUG
-  #define MEM_ALLOC_SIZE 0 /* It's hard to debug BOF with tiny alloc */
-  #else
-  #define MEM_ALLOC_SIZE 0x10000
-  #endif
-
-  if (size > MEM_ALLOC_SIZE)
-  {
-    // we can't handle it here
-
-    return mem_alloc (size);
-  }
-
-  static char *buffer  = NULL;
-  static size_t bufree = 0;
-
-  if (size > bufree)
-  {
-    buffer = mem_alloc (MEM_ALLOC_SIZE);
-    bufree = MEM_ALLOC_SIZE;
-  }
-
-  char *p = buffer;
-
-  buffer += size;
-  bufree -= size;
-
-  return p;
-}
-
-static void usage_mini_print (const char *progname)
-{
-  int i;
-
-  for (i = 0; USAGE_MINI[i] != NULL; i++)
-  {
-    printf (USAGE_MINI[i], progname);
-
-    #ifdef APPLE
-    putchar ('\n');
-    #endif
-
-    #ifdef OSX
-    putchar ('\n');
-    #endif
-
-    #ifdef LINUX
-    putchar ('\n');
-    #endif
-
-    #ifdef WINDOWS
-    putchar ('\r');
-    putchar ('\n');
-    #endif
-  }
-}
-
-static void usage_big_print (const char *progname)
-{
-  int i;
-
-  for (i = 0; USAGE_BIG[i] != NULL; i++)
-  {
-    printf (USAGE_BIG[i], progname);
-
-    #ifdef APPLE
-    putchar ('\n');
-    #endif
-
-    #ifdef OSX
-    putchar ('\n');
-    #endif
-
-    #ifdef LINUX
-    putchar ('\n');
-    #endif
-
-    #ifdef WINDOWS
-    putchar ('\r');
-    putchar ('\n');
-    #endif
-  }
-}
-
-static void check_realloc_elems (db_entry_t *db_entry)
-{
-  if (db_entry->elems_cnt == db_entry->elems_alloc)
-  {
-    const u64 elems_alloc = db_entry->elems_alloc;
-
-    const u64 elems_alloc_new = elems_alloc + ALLOC_NEW_ELEMS;
-
-    db_entry->elems_buf = (elem_t *) realloc (db_entry->elems_buf, elems_alloc_new * sizeof (elem_t));
-
-    if (db_entry->elems_buf == NULL)
-    {
-      fprintf (stderr, "Out of memory trying to allocate %zu bytes\n", (size_t) elems_alloc_new * sizeof (elem_t));
-
-      exit (-1);
-    }
-
-    memset (&db_entry->elems_buf[elems_alloc], 0, ALLOC_NEW_ELEMS * sizeof (elem_t));
-
-    db_entry->elems_alloc = elems_alloc_new;
-  }
-}
-
-static void check_realloc_chains (db_entry_t *db_entry)
-{
-  if (db_entry->chains_cnt == db_entry->chains_alloc)
-  {
-    const u64 chains_alloc = db_entry->chains_alloc;
-
-    const u64 chains_alloc_new = chains_alloc + ALLOC_NEW_CHAINS;
-
-    db_entry->chains_buf = (chain_t *) realloc (db_entry->chains_buf, chains_alloc_new * sizeof (chain_t));
-
-    if (db_entry->chains_buf == NULL)
-    {
-      fprintf (stderr, "Out of memory trying to allocate %zu bytes\n", (size_t) chains_alloc_new * sizeof (chain_t));
-
-      exit (-1);
-    }
-
-    memset (&db_entry->chains_buf[chains_alloc], 0, ALLOC_NEW_CHAINS * sizeof (chain_t));
-
-    db_entry->chains_alloc = chains_alloc_new;
-  }
-}
-
-static int in_superchop (char *buf)
-{
-  int len = strlen (buf);
-
-  while (len)
-  {
-    if (buf[len - 1] == '\n')
-    {
-      len--;
-
-      continue;
-    }
-
-    if (buf[len - 1] == '\r')
-    {
-      len--;
-
-      continue;
-    }
-
-    break;
-  }
-
-  buf[len] = 0;
-
-  return len;
-}
-
-static void out_flush (out_t *out)
-{
-  const size_t n = fwrite (out->buf, 1, out->len, out->fp);
-
-  if (n != (size_t) out->len)
-  {
-    const int err = ferror (out->fp);
-
-    if (err == EPIPE)
-    {
-     // out->fp is probably closed
-
-      exit (0);
-    }
-
-    exit (-1);
-  }
-
-  out->len = 0;
-}
-
-static void out_push (out_t *out, const char *pw_buf, const int pw_len)
-{
-  memcpy (out->buf + out->len, pw_buf, pw_len);
-
-  out->len += pw_len;
-
-  if (out->len >= BUFSIZ - 100)
-  {
-    out_flush (out);
-  }
-}
-
-static int sort_by_cnt (const void *p1, const void *p2)
-{
-  const pw_order_t *o1 = (const pw_order_t *) p1;
-  const pw_order_t *o2 = (const pw_order_t *) p2;
-
-  // Descending order
-  if (o1->cnt > o2->cnt) return -1;
-  if (o1->cnt < o2->cnt) return  1;
-
-  return 0;
-}
-
-static int sort_by_ks (const void *p1, const void *p2)
-{
-  const chain_t *f1 = (const chain_t *) p1;
-  const chain_t *f2 = (const chain_t *) p2;
-
-  return mpz_cmp (f1->ks_cnt, f2->ks_cnt);
-}
-
-static int chain_valid_with_db (const chain_t *chain_buf, const db_entry_t *db_entries)
-{
-  const u8 *buf = chain_buf->buf;
-  const int cnt = chain_buf->cnt;
-
-  for (int idx = 0; idx < cnt; idx++)
-  {
-    const u8 db_key = buf[idx];
-
-    const db_entry_t *db_entry = &db_entries[db_key];
-
-    if (db_entry->elems_cnt == 0) return 0;
-  }
-
-  return 1;
-}
-
-static int chain_valid_with_cnt_min (const chain_t *chain_buf, const int elem_cnt_min)
-{
-  const int cnt = chain_buf->cnt;
-
-  if (cnt < elem_cnt_min) return 0;
-
-  return 1;
-}
-
-static int chain_valid_with_cnt_max (const chain_t *chain_buf, const int elem_cnt_max)
-{
-  const int cnt = chain_buf->cnt;
-
-  if (cnt > elem_cnt_max) return 0;
-
-  return 1;
-}
-
-static void chain_ks (const chain_t *chain_buf, const db_entry_t *db_entries, mpz_t *ks_cnt)
-{
-  const u8 *buf = chain_buf->buf;
-  const int cnt = chain_buf->cnt;
-
-  mpz_set_si (*ks_cnt, 1);
-
-  for (int idx = 0; idx < cnt; idx++)
-  {
-    const u8 db_key = buf[idx];
-
-    const db_entry_t *db_entry = &db_entries[db_key];
-
-    const u64 elems_cnt = db_entry->elems_cnt;
-
-    mpz_mul_ui (*ks_cnt, *ks_cnt, elems_cnt);
-  }
-}
-
-static void set_chain_ks_poses (const chain_t *chain_buf, const db_entry_t *db_entries, mpz_t *tmp, u64 cur_chain_ks_poses[OUT_LEN_MAX])
-{
-  const u8 *buf = chain_buf->buf;
-
-  const int cnt = chain_buf->cnt;
-
-  for (int idx = 0; idx < cnt; idx++)
-  {
-    const u8 db_key = buf[idx];
-
-    const db_entry_t *db_entry = &db_entries[db_key];
-
-    const u64 elems_cnt = db_entry->elems_cnt;
-
-    cur_chain_ks_poses[idx] = mpz_fdiv_ui (*tmp, elems_cnt);
-
-    mpz_div_ui (*tmp, *tmp, elems_cnt);
-  }
-}
-
-static void chain_set_pwbuf_init (const chain_t *chain_buf, const db_entry_t *db_entries, const u64 cur_chain_ks_poses[OUT_LEN_MAX], char *pw_buf)
-{
-  const u8 *buf = chain_buf->buf;
-
-  const u32 cnt = chain_buf->cnt;
-
-  for (u32 idx = 0; idx < cnt; idx++)
-  {
-    const u8 db_key = buf[idx];
-
-    const db_entry_t *db_entry = &db_entries[db_key];
-
-    const u64 elems_idx = cur_chain_ks_poses[idx];
-
-    memcpy (pw_buf, db_entry->elems_buf[elems_idx].buf, db_key);
-
-    pw_buf += db_key;
-  }
-}
-
-static void chain_set_pwbuf_increment (const chain_t *chain_buf, const db_entry_t *db_entries, u64 cur_chain_ks_poses[OUT_LEN_MAX], char *pw_buf)
-{
-  const u8 *buf = chain_buf->buf;
-
-  const int cnt = chain_buf->cnt;
-
-  for (int idx = 0; idx < cnt; idx++)
-  {
-    const u8 db_key = buf[idx];
-
-    const db_entry_t *db_entry = &db_entries[db_key];
-
-    const u64 elems_cnt = db_entry->elems_cnt;
-
-    cur_chain_ks_poses[idx]++;
-
-    const u64 elems_idx = cur_chain_ks_poses[idx];
-
-    if (elems_idx < elems_cnt)
-    {
-      memcpy (pw_buf, db_entry->elems_buf[elems_idx].buf, db_key);
-
-      break;
-    }
-
-    cur_chain_ks_poses[idx] = 0;
-
-    memcpy (pw_buf, db_entry->elems_buf[0].buf, db_key);
-
-    pw_buf += db_key;
-  }
-}
-
-static void chain_gen_with_idx (chain_t *chain_buf, const int len1, const int chains_idx)
-{
-  chain_buf->cnt = 0;
-
-  u8 db_key = 1;
-
-  for (int chains_shr = 0; chains_shr < len1; chains_shr++)
-  {
-    if ((chains_idx >> chains_shr) & 1)
-    {
-      chain_buf->buf[chain_buf->cnt] = db_key;
-
-      chain_buf->cnt++;
-
-      db_key = 1;
-    }
-    else
-    {
-      db_key++;
-    }
-  }
-
-  chain_buf->buf[chain_buf->cnt] = db_key;
-
-  chain_buf->cnt++;
-}
-
-static char *add_elem (db_entry_t *db_entry, char *input_buf, int input_len)
-{
-  check_realloc_elems (db_entry);
-
-  elem_t *elem_buf = &db_entry->elems_buf[db_entry->elems_cnt];
-
-  elem_buf->buf = malloc_tiny (input_len);
-
-  memcpy (elem_buf->buf, input_buf, input_len);
-
-  db_entry->elems_cnt++;
-
-  return (char *) elem_buf->buf;
-}
-
-static u32 input_hash (char *input_buf, int input_len, const int hash_mask)
-{
-  u32 h = 0;
-
-  for (int i = 0; i < input_len; i++)
-  {
-    h = (h * 33) + input_buf[i];
-  }
-
-  return h & hash_mask;
-}
-
-static void add_uniq (db_entry_t *db_entry, char *input_buf, int input_len)
-{
-  uniq_t *uniq = db_entry->uniq;
-
-  const u32 h = input_hash (input_buf, input_len, uniq->hash_mask);
-
-  u32 cur = uniq->hash[h];
-
-  u32 prev = cur;
-
-  while (cur != ENTRY_END_HASH)
-  {
-    if (memcmp (input_buf, uniq->data[cur].element, input_len) == 0) return;
-
-    prev = cur;
-
-    cur = uniq->data[cur].next;
-  }
-
-  const u32 index = uniq->index;
-
-  if (prev == ENTRY_END_HASH)
-  {
-    uniq->hash[h] = index;
-  }
-  else
-  {
-    uniq->data[prev].next = index;
-  }
-
-  if (index == uniq->alloc)
-  {
-    uniq->alloc += ALLOC_NEW_DUPES;
-
-    uniq->data = realloc (uniq->data, uniq->alloc * sizeof (uniq_data_t));
-  }
-
-  uniq->data[index].element = add_elem (db_entry, input_buf, input_len);
-  uniq->data[index].next    = ENTRY_END_HASH;
-
-  uniq->index++;
-}
-
-mpz_t save;
-
-static void catch_int (int signum)
-{
-  FILE *fp = fopen (SAVE_FILE, "w");
-
-  if (fp == NULL) fp = stderr;
-
-  mpz_out_str (fp, 10, save);
-
-  fprintf (fp, "\n");
-
-  fclose (fp);
-
-  exit (signum==0?0:signum);
-}
-
-int main (int argc, char *argv[])
-{
-  mpz_t pw_ks_pos[OUT_LEN_MAX + 1];
-  mpz_t pw_ks_cnt[OUT_LEN_MAX + 1];
-
-  mpz_t iter_max;         mpz_init_set_si (iter_max,        0);
-  mpz_t total_ks_cnt;     mpz_init_set_si (total_ks_cnt,    0);
-  mpz_t total_ks_pos;     mpz_init_set_si (total_ks_pos,    0);
-  mpz_t total_ks_left;    mpz_init_set_si (total_ks_left,   0);
-  mpz_t skip;             mpz_init_set_si (skip,            0);
-  mpz_t limit;            mpz_init_set_si (limit,           0);
-  mpz_t tmp;              mpz_init_set_si (tmp,             0);
-
-  int     version       = 0;
-  int     usage         = 0;
-  int     keyspace      = 0;
-  int     pw_min        = PW_MIN;
-  int     pw_max        = PW_MAX;
-  int     elem_cnt_min  = ELEM_CNT_MIN;
-  int     elem_cnt_max  = ELEM_CNT_MAX;
-  int     wl_dist_len   = WL_DIST_LEN;
-  int     wl_max        = WL_MAX;
-  int     case_permute  = CASE_PERMUTE;
-  int     dupe_check    = DUPE_CHECK;
-  int     save_pos      = SAVE_POS;
-  char   *output_file   = NULL;
-
-  #define IDX_VERSION               'V'
-  #define IDX_USAGE                 'h'
-  #define IDX_PW_MIN                0x1000
-  #define IDX_PW_MAX                0x2000
-  #define IDX_ELEM_CNT_MIN          0x3000
-  #define IDX_ELEM_CNT_MAX          0x4000
-  #define IDX_KEYSPACE              0x5000
-  #define IDX_WL_DIST_LEN           0x6000
-  #define IDX_WL_MAX                0x7000
-  #define IDX_CASE_PERMUTE          0x8000
-  #define IDX_SAVE_POS_DISABLE      0x9000
-  #define IDX_DUPE_CHECK_DISABLE    'c'
-  #define IDX_SKIP                  's'
-  #define IDX_LIMIT                 'l'
-  #define IDX_OUTPUT_FILE           'o'
-
-  struct option long_options[] =
-  {
-    {"version",               no_argument,       0, IDX_VERSION},
-    {"help",                  no_argument,       0, IDX_USAGE},
-    {"keyspace",              no_argument,       0, IDX_KEYSPACE},
-    {"pw-min",                required_argument, 0, IDX_PW_MIN},
-    {"pw-max",                required_argument, 0, IDX_PW_MAX},
-    {"elem-cnt-min",          required_argument, 0, IDX_ELEM_CNT_MIN},
-    {"elem-cnt-max",          required_argument, 0, IDX_ELEM_CNT_MAX},
-    {"wl-dist-len",           no_argument,       0, IDX_WL_DIST_LEN},
-    {"wl-max",                required_argument, 0, IDX_WL_MAX},
-    {"case-permute",          no_argument,       0, IDX_CASE_PERMUTE},
-    {"dupe-check-disable",    no_argument,       0, IDX_DUPE_CHECK_DISABLE},
-    {"save-pos-disable",      no_argument,       0, IDX_SAVE_POS_DISABLE},
-    {"skip",                  required_argument, 0, IDX_SKIP},
-    {"limit",                 required_argument, 0, IDX_LIMIT},
-    {"output-file",           required_argument, 0, IDX_OUTPUT_FILE},
-    {0, 0, 0, 0}
-  };
-
-  int elem_cnt_max_chgd = 0;
-
-  int option_index = 0;
-
-  int c;
-
-  while ((c = getopt_long (argc, argv, "Vhs:l:o:c", long_options, &option_index)) != -1)
-  {
-    switch (c)
-    {
-      case IDX_VERSION:               version           = 1;              break;
-      case IDX_USAGE:                 usage             = 1;              break;
-      case IDX_KEYSPACE:              keyspace          = 1;              break;
-      case IDX_PW_MIN:                pw_min            = atoi (optarg);  break;
-      case IDX_PW_MAX:                pw_max            = atoi (optarg);  break;
-      case IDX_ELEM_CNT_MIN:          elem_cnt_min      = atoi (optarg);  break;
-      case IDX_ELEM_CNT_MAX:          elem_cnt_max      = atoi (optarg);
-                                      elem_cnt_max_chgd = 1;              break;
-      case IDX_WL_DIST_LEN:           wl_dist_len       = 1;              break;
-      case IDX_WL_MAX:                wl_max            = atoi (optarg);  break;
-      case IDX_CASE_PERMUTE:          case_permute      = 1;              break;
-      case IDX_DUPE_CHECK_DISABLE:    dupe_check        = 0;              break;
-      case IDX_SAVE_POS_DISABLE:      save_pos          = 0;              break;
-      case IDX_SKIP:                  mpz_set_str (skip,  optarg, 10);    break;
-      case IDX_LIMIT:                 mpz_set_str (limit, optarg, 10);    break;
-      case IDX_OUTPUT_FILE:           output_file       = optarg;         break;
-
-      default: return (-1);
-    }
-  }
-
-  if (elem_cnt_max_chgd == 0)
-  {
-    elem_cnt_max = MIN (pw_max, ELEM_CNT_MAX);
-  }
-
-  if (usage)
-  {
-    usage_big_print (argv[0]);
-
-    return (-1);
-  }
-
-  if (version)
-  {
-    printf ("v%4.02f\n", (double) VERSION_BIN / 100);
-
-    return (-1);
-  }
-
-  if ((optind != argc) && (optind + 1 != argc))
-  {
-    usage_mini_print (argv[0]);
-
-    return (-1);
-  }
-
-  char *wordlist = NULL;
-
-  if (optind + 1 == argc)
-  {
-    wordlist = argv[optind];
-  }
-
-  if (pw_min <= 0)
-  {
-    fprintf (stderr, "Value of --pw-min (%d) must be greater than %d\n", pw_min, 0);
-
-    return (-1);
-  }
-
-  if (pw_max <= 0)
-  {
-    fprintf (stderr, "Value of --pw-max (%d) must be greater than %d\n", pw_max, 0);
-
-    return (-1);
-  }
-
-  if (elem_cnt_min <= 0)
-  {
-    fprintf (stderr, "Value of --elem-cnt-min (%d) must be greater than %d\n", elem_cnt_min, 0);
-
-    return (-1);
-  }
-
-  if (elem_cnt_max < (1 - pw_max))
-  {
-    fprintf (stderr, "Value of --elem-cnt-max (%d) must be greater than %d\n", elem_cnt_max, (0 - pw_max));
-
-    return (-1);
-  }
-
-  if (pw_min > pw_max)
-  {
-    fprintf (stderr, "Value of --pw-min (%d) must be smaller or equal than value of --pw-max (%d)\n", pw_min, pw_max);
-
-    return (-1);
-  }
-
-  if (elem_cnt_max > 0 && elem_cnt_min > elem_cnt_max)
-  {
-    fprintf (stderr, "Value of --elem-cnt-min (%d) must be smaller or equal than value of --elem-cnt-max (%d)\n", elem_cnt_min, elem_cnt_max);
-
-    return (-1);
-  }
-
-  if (pw_min < IN_LEN_MIN)
-  {
-    fprintf (stderr, "Value of --pw-min (%d) must be greater or equal than %d\n", pw_min, IN_LEN_MIN);
-
-    return (-1);
-  }
-
-  if (pw_max > OUT_LEN_MAX)
-  {
-    fprintf (stderr, "Value of --pw-max (%d) must be smaller or equal than %d\n", pw_max, OUT_LEN_MAX);
-
-    return (-1);
-  }
-
-  if (elem_cnt_max > pw_max)
-  {
-    fprintf (stderr, "Value of --elem-cnt-max (%d) must be smaller or equal than value of --pw-max (%d)\n", elem_cnt_max, pw_max);
-
-    return (-1);
-  }
-
-  /**
-   * OS specific settings
-   */
-
-  #ifdef WINDOWS
-  setmode (fileno (stdout), O_BINARY);
-  #endif
-
-  /**
-   * alloc some space
-   */
-
-  db_entry_t *db_entries   = (db_entry_t *) calloc (pw_max + 1, sizeof (db_entry_t));
-  pw_order_t *pw_orders    = (pw_order_t *) calloc (pw_max + 1, sizeof (pw_order_t));
-  u64        *wordlen_dist = (u64 *)        calloc (pw_max + 1, sizeof (u64));
-
-  out_t *out = (out_t *) mem_alloc (sizeof (out_t));
-
-  out->fp  = stdout;
-  out->len = 0;
-
-  if (dupe_check)
-  {
-    int in_max = MIN(IN_LEN_MAX, pw_max);
-
-    for (int pw_len = IN_LEN_MIN; pw_len <= in_max; pw_len++)
-    {
-      db_entry_t *db_entry = &db_entries[pw_len];
-
-      const u32 hash_size = 1 << DEF_HASH_LOG_SIZE[pw_len];
-      const u32 hash_alloc = ALLOC_NEW_DUPES;
-
-      uniq_t *uniq = mem_alloc (sizeof (uniq_t));
-
-      uniq->hash_mask = hash_size - 1;
-      uniq->data  = mem_alloc (hash_alloc * sizeof (uniq_data_t));
-      uniq->hash  = mem_alloc (hash_size  * sizeof (u32));
-      uniq->index = 0;
-      uniq->alloc = hash_alloc;
-
-      memset (uniq->hash, 0xff, hash_size * sizeof (u32));
-
-      db_entry->uniq = uniq;
-    }
-  }
-
-  /**
-   * files
-   */
-
-  if (output_file)
-  {
-    out->fp = fopen (output_file, "ab");
-
-    if (out->fp == NULL)
-    {
-      fprintf (stderr, "%s: %s\n", output_file, strerror (errno));
-
-      return (-1);
-    }
-  }
-
-  /*
-   * catch signal user interrupt
-   */
-
-  if (save_pos)
-  {
-    signal (SIGINT, catch_int);
-  }
-
-  /**
-   * load elems from stdin
-   */
-
-  FILE *read_fp = stdin;
-
-  if (wordlist)
-  {
-    read_fp = fopen (wordlist, "rb");
-
-    if (read_fp == NULL)
-    {
-      fprintf (stderr, "%s: %s\n", wordlist, strerror (errno));
-
-      return (-1);
-    }
-  }
-
-  int wl_cnt = 0;
-
-  while (!feof (read_fp))
-  {
-    char buf[BUFSIZ];
-
-    char *input_buf = fgets (buf, sizeof (buf), read_fp);
-
-    if (input_buf == NULL) continue;
-
-    const int input_len = in_superchop (input_buf);
-
-    if (input_len < IN_LEN_MIN) continue;
-    if (input_len > IN_LEN_MAX) continue;
-
-    if (input_len > pw_max) continue;
-
-    db_entry_t *db_entry = &db_entries[input_len];
-
-    if (!dupe_check)
-    {
-      add_elem (db_entry, input_buf, input_len);
-    }
-    else
-    {
-      add_uniq (db_entry, input_buf, input_len);
-    }
-
-    if (case_permute)
-    {
-      const char old_c = input_buf[0];
-
-      const char new_cu = toupper (old_c);
-      const char new_cl = tolower (old_c);
-
-      if (old_c != new_cu)
-      {
-        input_buf[0] = new_cu;
-
-        if (!dupe_check)
-        {
-          add_elem (db_entry, input_buf, input_len);
-        }
-        else
-        {
-          add_uniq (db_entry, input_buf, input_len);
-        }
-      }
-
-      if (old_c != new_cl)
-      {
-        input_buf[0] = new_cl;
-
-        if (!dupe_check)
-        {
-          add_elem (db_entry, input_buf, input_len);
-        }
-        else
-        {
-          add_uniq (db_entry, input_buf, input_len);
-        }
-      }
-    }
-
-    wl_cnt++;
-
-    if (wl_max > 0 && wl_cnt == wl_max) break;
-  }
-
-  if (wordlist)
-  {
-    fclose (read_fp);
-  }
-
-  if (dupe_check)
-  {
-    int in_max = MIN(IN_LEN_MAX, pw_max);
-
-    for (int pw_len = IN_LEN_MIN; pw_len <= in_max; pw_len++)
-    {
-      db_entry_t *db_entry = &db_entries[pw_len];
-
-      uniq_t *uniq = db_entry->uniq;
-
-      free (uniq->hash);
-      free (uniq->data);
-      free (uniq);
-    }
-  }
-
-  /**
-   * init chains
-   */
-
-  for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
-  {
-    db_entry_t *db_entry = &db_entries[pw_len];
-
-    const int pw_len1 = pw_len - 1;
-
-    const u32 chains_cnt = 1 << pw_len1;
-
-    u8 buf[OUT_LEN_MAX];
-
-    chain_t chain_buf_new;
-
-    chain_buf_new.buf = buf;
-
-    for (u32 chains_idx = 0; chains_idx < chains_cnt; chains_idx++)
-    {
-      chain_gen_with_idx (&chain_buf_new, pw_len1, chains_idx);
-
-      // make sure all the elements really exist
-
-      int valid1 = chain_valid_with_db (&chain_buf_new, db_entries);
-
-      if (valid1 == 0) continue;
-
-      // boost by verify element count to be inside a specific range
-
-      int valid2 = chain_valid_with_cnt_min (&chain_buf_new, elem_cnt_min);
-
-      if (valid2 == 0) continue;
-
-      int eff_elem_cnt_max;
-
-      if (elem_cnt_max > 0)
-      {
-        eff_elem_cnt_max = elem_cnt_max;
-      }
-      else
-      {
-        eff_elem_cnt_max = pw_len + elem_cnt_max;
-
-        if (eff_elem_cnt_max <= elem_cnt_min) continue;
-      }
-
-      int valid3 = chain_valid_with_cnt_max (&chain_buf_new, eff_elem_cnt_max);
-
-      if (valid3 == 0) continue;
-
-      // add chain to database
-
-      check_realloc_chains (db_entry);
-
-      chain_t *chain_buf = &db_entry->chains_buf[db_entry->chains_cnt];
-
-      memcpy (chain_buf, &chain_buf_new, sizeof (chain_t));
-
-      chain_buf->buf = malloc_tiny (pw_len);
-
-      memcpy (chain_buf->buf, chain_buf_new.buf, pw_len);
-
-      mpz_init_set_si (chain_buf->ks_cnt, 0);
-      mpz_init_set_si (chain_buf->ks_pos, 0);
-
-      db_entry->chains_cnt++;
-    }
-
-    memset (db_entry->cur_chain_ks_poses, 0, OUT_LEN_MAX * sizeof (u64));
-  }
-
-  /**
-   * calculate password candidate output length distribution
-   */
-
-  if (wl_dist_len)
-  {
-    for (int pw_len = IN_LEN_MIN; pw_len <= pw_max; pw_len++)
-    {
-      if (pw_len <= IN_LEN_MAX)
-      {
-        db_entry_t *db_entry = &db_entries[pw_len];
-
-        wordlen_dist[pw_len] = db_entry->elems_cnt;
-      }
-      else
-      {
-        wordlen_dist[pw_len] = 1;
-      }
-    }
-  }
-  else
-  {
-    for (int pw_len = IN_LEN_MIN; pw_len <= pw_max; pw_len++)
-    {
-      if (pw_len < DEF_WORDLEN_DIST_CNT)
-      {
-        wordlen_dist[pw_len] = DEF_WORDLEN_DIST[pw_len];
-      }
-      else
-      {
-        wordlen_dist[pw_len] = 1;
-      }
-    }
-  }
-
-  /**
-   * Calculate keyspace stuff
-   */
-
-  for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
-  {
-    db_entry_t *db_entry = &db_entries[pw_len];
-
-    int      chains_cnt = db_entry->chains_cnt;
-    chain_t *chains_buf = db_entry->chains_buf;
-
-    mpz_set_si (tmp, 0);
-
-    for (int chains_idx = 0; chains_idx < chains_cnt; chains_idx++)
-    {
-      chain_t *chain_buf = &chains_buf[chains_idx];
-
-      chain_ks (chain_buf, db_entries, &chain_buf->ks_cnt);
-
-      mpz_add (tmp, tmp, chain_buf->ks_cnt);
-    }
-
-    mpz_add (total_ks_cnt, total_ks_cnt, tmp);
-
-    if (mpz_cmp_si (skip, 0))
-    {
-      mpz_init_set (pw_ks_cnt[pw_len], tmp);
-    }
-  }
-
-  if (total_ks_cnt == UINT128_MAX)
-  {
-    fprintf (stderr, "Warning: %d-bit keyspace saturated\n", FAKE_GMP);
-  }
-
-  if (keyspace)
-  {
-    mpz_out_str (stdout, 10, total_ks_cnt);
-
-    printf ("\n");
-
-    return 0;
-  }
-
-  /**
-   * sort chains by ks
-   */
-
-  for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
-  {
-    db_entry_t *db_entry = &db_entries[pw_len];
-
-    chain_t *chains_buf = db_entry->chains_buf;
-
-    const int chains_cnt = db_entry->chains_cnt;
-
-    qsort (chains_buf, chains_cnt, sizeof (chain_t), sort_by_ks);
-  }
-
-  /**
-   * sort global order by password length counts
-   */
-
-  for (int pw_len = pw_min, order_pos = 0; pw_len <= pw_max; pw_len++, order_pos++)
-  {
-    db_entry_t *db_entry = &db_entries[pw_len];
-
-    const u64 elems_cnt = db_entry->elems_cnt;
-
-    pw_order_t *pw_order = &pw_orders[order_pos];
-
-    pw_order->len = pw_len;
-    pw_order->cnt = elems_cnt;
-  }
-
-  const int order_cnt = pw_max + 1 - pw_min;
-
-  qsort (pw_orders, order_cnt, sizeof (pw_order_t), sort_by_cnt);
-
-  /**
-   * seek to some starting point
-   */
-
-  if (mpz_cmp_si (skip, 0))
-  {
-    if (mpz_cmp (skip, total_ks_cnt) >= 0)
-    {
-      fprintf (stderr, "Value of --skip must be smaller than total keyspace\n");
-
-      return (-1);
-    }
-  }
-
-  if (mpz_cmp_si (limit, 0))
-  {
-    if (mpz_cmp (limit, total_ks_cnt) > 0)
-    {
-      fprintf (stderr, "Value of --limit cannot be larger than total keyspace\n");
-
-      return (-1);
-    }
-
-    mpz_add (tmp, skip, limit);
-
-    if (mpz_cmp (tmp, total_ks_cnt) > 0)
-    {
-      fprintf (stderr, "Value of --skip + --limit cannot be larger than total keyspace\n");
-
-      return (-1);
-    }
-
-    mpz_set (total_ks_cnt, tmp);
-  }
-
-  mpz_init_set (save, skip);
-
-  /**
-   * skip to the first main loop that will output a password
-   */
-
-  if (mpz_cmp_si (skip, 0))
-  {
-    mpz_t skip_left;  mpz_init_set (skip_left, skip);
-    mpz_t main_loops; mpz_init (main_loops);
-
-    u64 outs_per_main_loop = 0;
-
-    for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
-    {
-      mpz_init_set_si (pw_ks_pos[pw_len], 0);
-
-      outs_per_main_loop += wordlen_dist[pw_len];
-    }
-
-    // find pw_ks_pos[]
-
-    while (1)
-    {
-      mpz_fdiv_q_ui (main_loops, skip_left, outs_per_main_loop);
-
-      if (mpz_cmp_si (main_loops, 0) == 0)
-      {
-        break;
-      }
-
-      // increment the main loop "main_loops" times
-
-      for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
-      {
-        if (mpz_cmp (pw_ks_pos[pw_len], pw_ks_cnt[pw_len]) < 0)
-        {
-          mpz_mul_ui (tmp, main_loops, wordlen_dist[pw_len]);
-
-          mpz_add (pw_ks_pos[pw_len], pw_ks_pos[pw_len], tmp);
-
-          mpz_sub (skip_left, skip_left, tmp);
-
-          if (mpz_cmp (pw_ks_pos[pw_len], pw_ks_cnt[pw_len]) > 0)
-          {
-            mpz_sub (tmp, pw_ks_pos[pw_len], pw_ks_cnt[pw_len]);
-
-            mpz_add (skip_left, skip_left, tmp);
-          }
-        }
-      }
-
-      outs_per_main_loop = 0;
-
-      for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
-      {
-        if (mpz_cmp (pw_ks_pos[pw_len], pw_ks_cnt[pw_len]) < 0)
-        {
-          outs_per_main_loop += wordlen_dist[pw_len];
-        }
-      }
-    }
-
-    mpz_sub (total_ks_pos, skip, skip_left);
-
-    // set db_entries to pw_ks_pos[]
-
-    for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
-    {
-      db_entry_t *db_entry = &db_entries[pw_len];
-
-      int      chains_cnt = db_entry->chains_cnt;
-      chain_t *chains_buf = db_entry->chains_buf;
-
-      mpz_set (tmp, pw_ks_pos[pw_len]);
-
-      for (int chains_idx = 0; chains_idx < chains_cnt; chains_idx++)
-      {
-        chain_t *chain_buf = &chains_buf[chains_idx];
-
-        if (mpz_cmp (tmp, chain_buf->ks_cnt) < 0)
-        {
-          mpz_set (chain_buf->ks_pos, tmp);
-
-          set_chain_ks_poses (chain_buf, db_entries, &tmp, db_entry->cur_chain_ks_poses);
-
-          break;
-        }
-
-        mpz_sub (tmp, tmp, chain_buf->ks_cnt);
-
-        db_entry->chains_pos++;
-      }
-    }
-
-    // clean up
-
-    for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
-    {
-      mpz_clear (pw_ks_cnt[pw_len]);
-      mpz_clear (pw_ks_pos[pw_len]);
-    }
-
-    mpz_clear (skip_left);
-    mpz_clear (main_loops);
-  }
-
-  /**
-   * loop
-   */
-
-  while (mpz_cmp (total_ks_pos, total_ks_cnt) < 0)
-  {
-    for (int order_pos = 0; order_pos < order_cnt; order_pos++)
-    {
-      pw_order_t *pw_order = &pw_orders[order_pos];
-
-      const int pw_len = pw_order->len;
-
-      char pw_buf[BUFSIZ];
-
-      pw_buf[pw_len] = '\n';
-
-      db_entry_t *db_entry = &db_entries[pw_len];
-
-      const u64 outs_cnt = wordlen_dist[pw_len];
-
-      u64 outs_pos = 0;
-
-      while (outs_pos < outs_cnt)
-      {
-        const int chains_cnt = db_entry->chains_cnt;
-        const int chains_pos = db_entry->chains_pos;
-
-        if (chains_pos == chains_cnt) break;
-
-        chain_t *chains_buf = db_entry->chains_buf;
-
-        chain_t *chain_buf = &chains_buf[chains_pos];
-
-        mpz_sub (total_ks_left, total_ks_cnt, total_ks_pos);
-
-        mpz_sub (iter_max, chain_buf->ks_cnt, chain_buf->ks_pos);
-
-        if (mpz_cmp (total_ks_left, iter_max) < 0)
-        {
-          mpz_set (iter_max, total_ks_left);
-        }
-
-        const u64 outs_left = outs_cnt - outs_pos;
-
-        mpz_set_ui (tmp, outs_left);
-
-        if (mpz_cmp (tmp, iter_max) < 0)
-        {
-          mpz_set (iter_max, tmp);
-        }
-
-        const u64 iter_max_u64 = mpz_get_ui (iter_max);
-
-        mpz_add (tmp, total_ks_pos, iter_max);
-
-        if (mpz_cmp (tmp, skip) > 0)
-        {
-          u64 iter_pos_u64 = 0;
-
-          if (mpz_cmp (total_ks_pos, skip) < 0)
-          {
-            mpz_sub (tmp, skip, total_ks_pos);
-
-            iter_pos_u64 = mpz_get_ui (tmp);
-
-            mpz_add (tmp, chain_buf->ks_pos, tmp);
-
-            set_chain_ks_poses (chain_buf, db_entries, &tmp, db_entry->cur_chain_ks_poses);
-          }
-
-          chain_set_pwbuf_init (chain_buf, db_entries, db_entry->cur_chain_ks_poses, pw_buf);
-
-          const u64 iter_pos_save = iter_max_u64 - iter_pos_u64;
-
-          while (iter_pos_u64 < iter_max_u64)
-          {
-            out_push (out, pw_buf, pw_len + 1);
-
-            chain_set_pwbuf_increment (chain_buf, db_entries, db_entry->cur_chain_ks_poses, pw_buf);
-
-            iter_pos_u64++;
-          }
-
-          mpz_add_ui (save, save, iter_pos_save);
-        }
-        else
-        {
-          mpz_add (tmp, chain_buf->ks_pos, iter_max);
-
-          set_chain_ks_poses (chain_buf, db_entries, &tmp, db_entry->cur_chain_ks_poses);
-        }
-
-        outs_pos += iter_max_u64;
-
-        mpz_add (total_ks_pos, total_ks_pos, iter_max);
-
-        mpz_add (chain_buf->ks_pos, chain_buf->ks_pos, iter_max);
-
-        if (mpz_cmp (chain_buf->ks_pos, chain_buf->ks_cnt) == 0)
-        {
-          db_entry->chains_pos++;
-
-          memset (db_entry->cur_chain_ks_poses, 0, OUT_LEN_MAX * sizeof (u64));
-        }
-
-        if (mpz_cmp (total_ks_pos, total_ks_cnt) == 0) break;
-      }
-
-      if (mpz_cmp (total_ks_pos, total_ks_cnt) == 0) break;
-    }
-  }
-
-  out_flush (out);
-
-  if (save_pos)
-  {
-    catch_int (0);
-  }
-
-  /**
-   * cleanup
-   */
-
-  mpz_clear (iter_max);
-  mpz_clear (total_ks_cnt);
-  mpz_clear (total_ks_pos);
-  mpz_clear (total_ks_left);
-  mpz_clear (skip);
-  mpz_clear (limit);
-  mpz_clear (tmp);
-  mpz_clear (save);
-
-  for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
-  {
-    db_entry_t *db_entry = &db_entries[pw_len];
-
-    if (db_entry->chains_buf)
-    {
-      int      chains_cnt = db_entry->chains_cnt;
-      chain_t *chains_buf = db_entry->chains_buf;
-
-      for (int chains_idx = 0; chains_idx < chains_cnt; chains_idx++)
-      {
-        chain_t *chain_buf = &chains_buf[chains_idx];
-
-        mpz_clear (chain_buf->ks_cnt);
-        mpz_clear (chain_buf->ks_pos);
-      }
-
-      free (db_entry->chains_buf);
-    }
-
-    if (db_entry->elems_buf)  free (db_entry->elems_buf);
-  }
-
-  free (out);
-  free (wordlen_dist);
-  free (pw_orders);
-  free (db_entries);
-
-  return 0;
-}
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#define __USE_MINGW_ANSI_STDIO 1
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+#include <getopt.h>
+#include <ctype.h>
+#include <signal.h>
+#include <pthread.h>
+
+#ifdef LINUX
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <sched.h>
+#endif
+
+#include "mpz_int128.h"
+#include "pp_shm.h"
+#include "pp_lz.h"
+#include "pp_copy.h"
+#include "pp_simd.h"
+#include "pp_jit.h"
+#include "pp_db.h"
+
+/**
+ * Name........: princeprocessor (pp)
+ * Description.: Standalone password candidate generator using the PRINCE algorithm
+ * Version.....: 0.22
+ * Authors.....: Jens Steube <jens.steube@gmail.com>
+ *               Steve Thomas (Sc00bz)
+ *               magnum <john.magnum@hushmail.com>
+ * License.....: MIT
+ */
+
+#define IN_LEN_MIN    1
+#define IN_LEN_MAX    32
+#define OUT_LEN_MAX   32 /* Limited by (u32)(1 << pw_len - 1) */
+#define PW_MIN        1
+#define PW_MAX        16
+#define ELEM_CNT_MIN  1
+#define ELEM_CNT_MAX  8
+#define WL_DIST_LEN   0
+#define WL_MAX        10000000
+#define CASE_PERMUTE  0
+#define DUPE_CHECK    1
+#define DUPE_MODE     DUPE_MODE_HASH
+#define SAVE_POS      1
+#define SAVE_FILE     "pp.save"
+#define WRITER_THREAD 0
+#define OUTPUT_SPLICE 0
+#define OUTPUT_URING  0
+#define OUTPUT_MMAP   0
+#define OUTPUT_FORMAT OUT_FORMAT_PLAIN
+#define OUTPUT_COMPRESS 0
+#define COMPRESS_THREADS 4
+#define THREADS       1
+#define LOAD_THREADS  1
+#define UNORDERED     0
+#define ORDER_TILE    0
+#define JIT           0
+#define ELEMS_STRIDE_POW2 0 /* pad each element to a power of two stride */
+
+#define VERSION_BIN   22
+
+#define ALLOC_NEW_ELEMS  0x40000
+#define ALLOC_NEW_CHAINS 0x10
+
+#define UNIQ_LOG_SIZE_MIN 12
+
+#define IN_BLOCK_SIZE    0x1000000
+
+#define PREFIXES_HASH_SIZE 0x1000
+#define PREFIX_SIZE_MAX    0x100000
+#define PREFIXES_SIZE_MAX  0x4000000
+
+#define ORDER_TILE_MAX     0x100000 /* KiB */
+
+#define OUT_BUFS_MAX     8
+#define OUT_BUF_SIZE     BUFSIZ
+#define OUT_BUF_SIZE_THR 0x400000
+#define OUT_PIPE_SIZE    0x100000
+#define OUT_BUF_SIZE_URI 0x100000
+#define OUT_MMAP_WINDOW  0x4000000
+#define OUT_REC_MAX      ((int) sizeof (pw_t))
+#define OUT_BUF_SIZE_LZ  0x100000
+#define OUT_LZ_THREADS_MAX (OUT_BUFS_MAX - 2)
+#define OUT_BLOCKS_MAX   0x100000
+
+#define GEN_THREADS_MAX  256
+#define GEN_JOBS_PER_THR 4
+#define GEN_JOB_SIZE     0x40000
+
+#define IN_THREADS_MAX   64
+#define IN_PARSE_FAIL    ((u64) -1)
+
+#define DUPE_SORT_SMALL  32
+
+#define MIN(a,b) (((a) < (b)) ? (a) : (b))
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef struct
+{
+  int len;
+  u64 cnt;
+
+} pw_order_t;
+
+typedef struct
+{
+  u8   *buf;
+  int   cnt;
+
+  mpz_t ks_cnt;
+  mpz_t ks_pos;
+
+} chain_t;
+
+typedef struct
+{
+  // open addressing with linear probing, a slot is the upper half of the
+  // element hash as fingerprint and the element index plus one, 0 is empty
+
+  u64 *slots;
+  u64  mask;
+  u64  cnt;
+
+} uniq_t;
+
+typedef struct
+{
+  pp_copy_fn copy[OUT_LEN_MAX];
+  const u8  *elems_buf[OUT_LEN_MAX];
+  u64        elems_stride[OUT_LEN_MAX];
+  u64        elems_cnt[OUT_LEN_MAX];
+  int        len[OUT_LEN_MAX];
+  int        cnt;
+
+  u64        poses[OUT_LEN_MAX];
+  int        prefix_cnt;
+  u64        prefix_radix[OUT_LEN_MAX];
+
+  u64        tile_cnt;
+  u64        tile_beg;
+  u64        tile_end;
+
+  int        jit_done;
+  pp_jit_fn  jit_fn;
+
+} chain_kern_t;
+
+typedef struct
+{
+  u8   key[OUT_LEN_MAX];
+  int  key_cnt;
+
+  u8  *buf;
+  u64  cnt;
+  int  len;
+
+} prefix_t;
+
+typedef struct
+{
+  u8      *elems_buf;
+  u64      elems_cnt;
+  u64      elems_alloc;
+  int      elems_stride;
+
+  chain_t *chains_buf;
+  int      chains_cnt;
+  int      chains_pos;
+  int      chains_alloc;
+
+  u64      cur_chain_ks_poses[OUT_LEN_MAX];
+  u64      cur_chain_ks_left;
+
+  chain_kern_t   chain_kern;
+  const chain_t *chain_kern_chain;
+
+  uniq_t  *uniq;
+
+} db_entry_t;
+
+typedef struct
+{
+  char *buf;
+  int   len;
+  u64   cnt;
+
+  int   busy;
+  u64   off;
+
+  char *zbuf;
+  int   zlen;
+  int   zready;
+  mpz_t pos;
+
+} out_slot_t;
+
+enum
+{
+  OUT_MODE_STDIO  = 0,
+  OUT_MODE_SPLICE = 1,
+  OUT_MODE_URING  = 2,
+  OUT_MODE_PWRITE = 3,
+  OUT_MODE_MMAP   = 4,
+  OUT_MODE_SHM    = 5,
+  OUT_MODE_BLOCK  = 6,
+
+};
+
+enum
+{
+  OUT_FORMAT_PLAIN = 0,
+  OUT_FORMAT_NUL   = 1,
+  OUT_FORMAT_LEN8  = 2,
+  OUT_FORMAT_FIXED = 3,
+  OUT_FORMAT_PW_T  = 4,
+  OUT_FORMAT_FRONT = 5,
+
+};
+
+enum
+{
+  DUPE_MODE_HASH      = 0,
+  DUPE_MODE_SORT      = 1,
+  DUPE_MODE_SORT_KEEP = 2,
+
+};
+
+#ifdef LINUX
+typedef struct
+{
+  int fd;
+
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+
+  void   *sq_ptr;
+  size_t  sq_size;
+  void   *cq_ptr;
+  size_t  cq_size;
+  size_t  sqes_size;
+
+} uring_t;
+#endif
+
+typedef struct
+{
+  u32 pw_len;
+  u32 cnt;
+
+} out_block_hdr_t;
+
+typedef struct out
+{
+  FILE *fp;
+  int   fd;
+  int   mode;
+  u64   off;
+
+  struct out *parent;
+  int         pw_len;
+
+  #ifdef LINUX
+  uring_t uring;
+
+  char *map_ptr;
+  u64   map_size;
+  u64   map_end;
+
+  const char     *shm_name;
+  pp_shm_hdr_t   *shm_hdr;
+  pp_shm_block_t *shm_blocks;
+  char           *shm_data;
+  u64             shm_size;
+  u64             shm_seq;
+  char           *shm_scratch;
+  #endif
+
+  char *buf;
+  int   len;
+  int   size;
+  int   rec_max;
+  u64   cnt;
+
+  char  prev[OUT_LEN_MAX];
+  int   prev_len;
+
+  out_slot_t slots[OUT_BUFS_MAX];
+  int        slots_cnt;
+  u64        slots_fill;
+  u64        slots_done;
+
+  int             thread_active;
+  int             thread_stop;
+  pthread_t       thread;
+  pthread_mutex_t mtx;
+  pthread_cond_t  cond;
+
+  int       format;
+  mpz_t     pos;
+  int       lz_threads_cnt;
+  pthread_t lz_threads[OUT_LZ_THREADS_MAX];
+  u64       slots_comp;
+
+} out_t;
+
+typedef struct
+{
+  const chain_t *chain_buf;
+
+  u64    cur_chain_ks_poses[OUT_LEN_MAX];
+  u64    cnt;
+
+  out_t *out;
+  int    pw_len;
+  int    rec_len;
+  int    rec_off;
+  char   rec_buf[OUT_REC_MAX];
+
+  char  *buf;
+  int    done;
+
+} gen_job_t;
+
+typedef struct
+{
+  const db_entry_t *db_entries;
+
+  int   format;
+  int   unordered;
+  FILE *fp;
+
+  gen_job_t *jobs;
+  int        jobs_cnt;
+  u64        jobs_fill;
+  u64        jobs_take;
+  u64        jobs_merge;
+
+  pthread_t *threads;
+  int        threads_cnt;
+  int        threads_stop;
+
+  pthread_mutex_t mtx;
+  pthread_cond_t  cond;
+
+} gen_t;
+
+typedef struct
+{
+  u8  *buf;
+  u32 *ords;
+  u64  cnt;
+  u64  alloc;
+
+} in_shard_t;
+
+typedef struct
+{
+  db_entry_t *db_entries;
+
+  int pw_max;
+  int dupe_check;
+  int case_permute;
+
+  int wl_max;
+  int wl_cnt;
+
+  int threads;
+
+  // set while a --load-threads worker parses, words are collected here
+  // per length instead of going to db_entries
+
+  in_shard_t *shards;
+
+  // set by --build-db, every byte read from the wordlist goes through it
+
+  pp_db_sum_t *sum;
+
+} in_t;
+
+typedef struct
+{
+  in_t in;
+
+  const char *buf;
+  u64         len;
+
+  in_shard_t shards[IN_LEN_MAX + 1];
+
+  u64 base;
+
+  pthread_t thread;
+
+} in_job_t;
+
+typedef struct
+{
+  in_t     *in;
+  in_job_t *jobs;
+  int       jobs_cnt;
+
+  int next_len;
+
+  pthread_mutex_t mtx;
+
+  pthread_t threads[IN_THREADS_MAX];
+
+} in_merge_t;
+
+typedef struct
+{
+  db_entry_t *db_entry;
+
+  int elem_len;
+  int ord_len;
+  int rec_len;
+
+  // the part of each record the current pass sorts on
+
+  int key_off;
+  int key_len;
+
+  u64 bounds[256 + 1];
+
+} dupe_sort_job_t;
+
+typedef struct
+{
+  dupe_sort_job_t *jobs;
+  int              jobs_cnt;
+
+  int pass;
+  int next;
+
+  pthread_mutex_t mtx;
+
+  pthread_t threads[IN_THREADS_MAX];
+
+} dupe_sort_t;
+
+/**
+ * Default word-length distribution, calculated out of first 1,000,000 entries of rockyou.txt
+ */
+
+#define DEF_WORDLEN_DIST_CNT 25
+
+static u64 DEF_WORDLEN_DIST[DEF_WORDLEN_DIST_CNT] =
+{
+  0,
+  15,
+  56,
+  350,
+  3315,
+  43721,
+  276252,
+  201748,
+  226412,
+  119885,
+  75075,
+  26323,
+  13373,
+  6353,
+  3540,
+  1877,
+  972,
+  311,
+  151,
+  81,
+  66,
+  21,
+  16,
+  13,
+  13
+};
+
+static const char *USAGE_MINI[] =
+{
+  "Usage: %s [options] [<] wordlist",
+  "",
+  "Try --help for more help.",
+  NULL
+};
+
+static const char *USAGE_BIG[] =
+{
+  "Usage: %s [options] [<] wordlist",
+  "",
+  "* Startup:",
+  "",
+  "  -V,  --version             Print version",
+  "  -h,  --help                Print help",
+  "",
+  "* Misc:",
+  "",
+  "       --keyspace            Calculate number of combinations",
+  "",
+  "* Optimization:",
+  "",
+  "       --pw-min=NUM          Print candidate if length is greater than NUM",
+  "       --pw-max=NUM          Print candidate if length is smaller than NUM",
+  "       --elem-cnt-min=NUM    Minimum number of elements per chain",
+  "       --elem-cnt-max=NUM    Maximum number of elements per chain",
+  "       --wl-dist-len         Calculate output length distribution from wordlist",
+  "       --wl-max=NUM          Load only NUM words from input wordlist or use 0 to disable",
+  "  -c,  --dupe-check-disable  Disable dupes check for faster initial load",
+  "       --dupe-mode=NAME      How the dupes check works: hash, sort or sort-keep-order",
+  "                             hash: hash table next to the elements (default)",
+  "                             sort: radix sort of the elements in place after loading, no index",
+  "                                   next to them but they end up sorted, resume with -s only with",
+  "                                   the same mode",
+  "                             sort-keep-order: like sort, then restores the wordlist order",
+  "                                   for 4 more bytes per element while sorting",
+  "       --save-pos-disable    Save the position for later resume with -s",
+  "       --order-tile=NUM      Walk the first two elements in tiles of NUM KiB of first elements,",
+  "                             changes the order, resume with -s only with the same NUM",
+  "",
+  "* Resources:",
+  "",
+  "  -s,  --skip=NUM            Skip NUM passwords from start (for distributed)",
+  "  -l,  --limit=NUM           Limit output to NUM passwords (for distributed)",
+  "       --threads=NUM         Generate with NUM threads, output order stays the same",
+  "       --unordered           Let --threads write in any order, each candidate still once, every",
+  "                             thread writes its own buffers to a file or stdout",
+  "       --load-threads=NUM    Load and dedupe the wordlist with NUM threads, same elements in the same order",
+  "       --jit                 Generate the candidate loops as machine code at runtime (x86-64 Linux only)",
+  "",
+  "* Files:",
+  "",
+  "  -o,  --output-file=FILE    Output-file",
+  "       --build-db=FILE       Load and dedupe the wordlist, write the elements of all lengths to FILE",
+  "                             and exit, --wl-max counts words of up to 32 characters then",
+  "       --db=FILE             Map the elements of a --build-db FILE instead of loading a wordlist,",
+  "                             the load options of the build apply, -c, --case-permute and",
+  "                             --dupe-mode have to match them if given, --wl-max has to load the",
+  "                             same words, a wordlist given as well is only checked to be the one",
+  "                             the FILE was built from",
+  "       --writer-thread       Write output from a separate thread using double buffering",
+  "       --output-splice       Use vmsplice() if output is a pipe (Linux only)",
+  "       --output-uring        Use io_uring for --output-file, pwrite() if unsupported (Linux only)",
+  "       --output-mmap         Preallocate --output-file and write to it through mmap() (Linux only)",
+  "       --output-format=NAME  Record framing of the output: plain, nul, len8, fixed, pw_t or front",
+  "                             plain: newline terminated (default)",
+  "                             nul:   NUL terminated",
+  "                             len8:  prefixed with a single byte holding the length",
+  "                             fixed: NUL padded to a stride of --pw-max rounded up to a power of two",
+  "                             pw_t:  hashcat pw_t structure",
+  "                             front: coded against the previous candidate, decode with ppdecode",
+  "       --output-shm=NAME     Publish pw_t records in the POSIX shared memory ring NAME (Linux only)",
+  "       --output-blocks=NUM   Group output in blocks of NUM candidates of the same length, each",
+  "                             block is preceded by its length and count as two 32 bit integers,",
+  "                             0 turns grouping off",
+  "       --output-split-len=DIR",
+  "                             Write candidates of each length to their own file DIR/<length>",
+  "       --output-compress     Compress the output in seekable blocks, decode with ppdecode",
+  "       --compress-threads=NUM",
+  "                             Number of threads compressing for --output-compress",
+  "",
+  "* Amplifier:",
+  "",
+  "       --case-permute        For each word in the wordlist that begins with a letter",
+  "                             generate a word with the opposite case of the first letter",
+  "",
+  NULL
+};
+
+static void *mem_alloc (const size_t size)
+{
+  void *res = malloc (size);
+
+  if (res == NULL)
+  {
+    fprintf (stderr, "malloc: %s\n", strerror (ENOMEM));
+
+    exit (-1);
+  }
+
+  return res;
+}
+
+static void *malloc_tiny (const size_t size)
+{
+  #ifdef DEBUG
+  #define MEM_ALLOC_SIZE 0 /* It's hard to debug BOF with tiny alloc */
+  #else
+  #define MEM_ALLOC_SIZE 0x10000
+  #endif
+
+  if (size > MEM_ALLOC_SIZE)
+  {
+    // we can't handle it here
+
+    return mem_alloc (size);
+  }
+
+  static char *buffer  = NULL;
+  static size_t bufree = 0;
+
+  if (size > bufree)
+  {
+    buffer = mem_alloc (MEM_ALLOC_SIZE);
+    bufree = MEM_ALLOC_SIZE;
+  }
+
+  char *p = buffer;
+
+  buffer += size;
+  bufree -= size;
+
+  return p;
+}
+
+static void usage_mini_print (const char *progname)
+{
+  int i;
+
+  for (i = 0; USAGE_MINI[i] != NULL; i++)
+  {
+    printf (USAGE_MINI[i], progname);
+
+    #ifdef APPLE
+    putchar ('\n');
+    #endif
+
+    #ifdef OSX
+    putchar ('\n');
+    #endif
+
+    #ifdef LINUX
+    putchar ('\n');
+    #endif
+
+    #ifdef WINDOWS
+    putchar ('\r');
+    putchar ('\n');
+    #endif
+  }
+}
+
+static void usage_big_print (const char *progname)
+{
+  int i;
+
+  for (i = 0; USAGE_BIG[i] != NULL; i++)
+  {
+    printf (USAGE_BIG[i], progname);
+
+    #ifdef APPLE
+    putchar ('\n');
+    #endif
+
+    #ifdef OSX
+    putchar ('\n');
+    #endif
+
+    #ifdef LINUX
+    putchar ('\n');
+    #endif
+
+    #ifdef WINDOWS
+    putchar ('\r');
+    putchar ('\n');
+    #endif
+  }
+}
+
+static int elems_stride (const int elem_len)
+{
+  #if ELEMS_STRIDE_POW2
+  int stride = 1;
+
+  while (stride < elem_len) stride <<= 1;
+
+  return stride;
+  #else
+  return elem_len;
+  #endif
+}
+
+static void check_realloc_elems (db_entry_t *db_entry, const int elem_len)
+{
+  // all elements of a db_entry have the same length, so they are stored
+  // back to back and element idx lives at elems_buf + idx * elems_stride
+
+  if (db_entry->elems_cnt == db_entry->elems_alloc)
+  {
+    if (db_entry->elems_stride == 0) db_entry->elems_stride = elems_stride (elem_len);
+
+    const size_t stride = db_entry->elems_stride;
+
+    const u64 elems_alloc = db_entry->elems_alloc;
+
+    const u64 elems_alloc_new = elems_alloc + ALLOC_NEW_ELEMS;
+
+    // the vector kernels load a full register from the last element
+
+    db_entry->elems_buf = (u8 *) realloc (db_entry->elems_buf, elems_alloc_new * stride + PP_SIMD_PAD);
+
+    if (db_entry->elems_buf == NULL)
+    {
+      fprintf (stderr, "Out of memory trying to allocate %zu bytes\n", (size_t) elems_alloc_new * stride);
+
+      exit (-1);
+    }
+
+    memset (db_entry->elems_buf + elems_alloc * stride, 0, ALLOC_NEW_ELEMS * stride);
+
+    db_entry->elems_alloc = elems_alloc_new;
+  }
+}
+
+static void check_realloc_chains (db_entry_t *db_entry)
+{
+  if (db_entry->chains_cnt == db_entry->chains_alloc)
+  {
+    const u64 chains_alloc = db_entry->chains_alloc;
+
+    const u64 chains_alloc_new = chains_alloc + ALLOC_NEW_CHAINS;
+
+    db_entry->chains_buf = (chain_t *) realloc (db_entry->chains_buf, chains_alloc_new * sizeof (chain_t));
+
+    if (db_entry->chains_buf == NULL)
+    {
+      fprintf (stderr, "Out of memory trying to allocate %zu bytes\n", (size_t) chains_alloc_new * sizeof (chain_t));
+
+      exit (-1);
+    }
+
+    memset (&db_entry->chains_buf[chains_alloc], 0, ALLOC_NEW_CHAINS * sizeof (chain_t));
+
+    db_entry->chains_alloc = chains_alloc_new;
+  }
+}
+
+static int in_superchop (char *buf)
+{
+  int len = strlen (buf);
+
+  while (len)
+  {
+    if (buf[len - 1] == '\n')
+    {
+      len--;
+
+      continue;
+    }
+
+    if (buf[len - 1] == '\r')
+    {
+      len--;
+
+      continue;
+    }
+
+    break;
+  }
+
+  buf[len] = 0;
+
+  return len;
+}
+
+mpz_t save;
+
+// with --output-split-len every length may have its own writer thread
+
+static pthread_mutex_t save_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static volatile sig_atomic_t stop_sig   = 0;
+static volatile sig_atomic_t out_active = 0;
+
+static int simd_level = PP_SIMD_NONE;
+
+static u64 order_tile = 0;
+
+static void save_add (const u64 cnt)
+{
+  pthread_mutex_lock (&save_mtx);
+
+  mpz_add_ui (save, save, cnt);
+
+  pthread_mutex_unlock (&save_mtx);
+}
+
+static int jit_enabled = 0;
+static int jit_term    = PP_JIT_TERM_NONE;
+
+#ifdef LINUX
+static void out_write_splice (out_t *out, out_slot_t *slot)
+{
+  // The pipe keeps referencing the pages after vmsplice () returned, until
+  // the last reader let go of them. A reader that splices them on, like
+  // tee or another pipe, can hold them for any time, so they are gifted
+  // and the slot continues with fresh pages.
+
+  struct iovec iov;
+
+  iov.iov_base = slot->buf;
+  iov.iov_len  = slot->len;
+
+  while (iov.iov_len)
+  {
+    const ssize_t n = vmsplice (out->fd, &iov, 1, SPLICE_F_GIFT);
+
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+
+      if (errno == EPIPE)
+      {
+        // out->fd is probably closed
+
+        exit (0);
+      }
+
+      exit (-1);
+    }
+
+    iov.iov_base  = (char *) iov.iov_base + n;
+    iov.iov_len  -= n;
+  }
+
+  // populated in one go, faulting them in one by one costs more than the
+  // copy vmsplice () saves
+
+  char *buf = mmap (NULL, out->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+
+  if (buf == MAP_FAILED)
+  {
+    fprintf (stderr, "mmap: %s\n", strerror (errno));
+
+    exit (-1);
+  }
+
+  munmap (slot->buf, out->size);
+
+  slot->buf = buf;
+}
+
+static void out_write_pwrite (out_t *out, const char *buf, const int len, u64 off)
+{
+  int left = len;
+
+  while (left)
+  {
+    const ssize_t n = pwrite (out->fd, buf, left, off);
+
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+
+      exit (-1);
+    }
+
+    buf  += n;
+    left -= n;
+    off  += n;
+  }
+}
+
+static int uring_init (uring_t *uring, const unsigned entries)
+{
+  struct io_uring_params params;
+
+  memset (&params, 0, sizeof (params));
+
+  uring->fd = syscall (__NR_io_uring_setup, entries, &params);
+
+  if (uring->fd < 0) return -1;
+
+  // IORING_OP_WRITE is not available before 5.6, ask the kernel
+
+  const size_t probe_size = sizeof (struct io_uring_probe) + 256 * sizeof (struct io_uring_probe_op);
+
+  struct io_uring_probe *probe = (struct io_uring_probe *) mem_alloc (probe_size);
+
+  memset (probe, 0, probe_size);
+
+  const int rc = syscall (__NR_io_uring_register, uring->fd, IORING_REGISTER_PROBE, probe, 256);
+
+  const int supported = (rc == 0) && (probe->last_op >= IORING_OP_WRITE) && (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+
+  free (probe);
+
+  if (supported == 0)
+  {
+    close (uring->fd);
+
+    return -1;
+  }
+
+  uring->sq_size   = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+  uring->cq_size   = params.cq_off.cqes  + params.cq_entries * sizeof (struct io_uring_cqe);
+  uring->sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+
+  uring->sq_ptr = mmap (NULL, uring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+  uring->cq_ptr = mmap (NULL, uring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_CQ_RING);
+  uring->sqes   = mmap (NULL, uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+
+  if ((uring->sq_ptr == MAP_FAILED) || (uring->cq_ptr == MAP_FAILED) || (uring->sqes == MAP_FAILED))
+  {
+    fprintf (stderr, "mmap: %s\n", strerror (errno));
+
+    exit (-1);
+  }
+
+  u8 *sq = (u8 *) uring->sq_ptr;
+  u8 *cq = (u8 *) uring->cq_ptr;
+
+  uring->sq_head  = (unsigned *) (sq + params.sq_off.head);
+  uring->sq_tail  = (unsigned *) (sq + params.sq_off.tail);
+  uring->sq_mask  = (unsigned *) (sq + params.sq_off.ring_mask);
+  uring->sq_array = (unsigned *) (sq + params.sq_off.array);
+
+  uring->cq_head  = (unsigned *) (cq + params.cq_off.head);
+  uring->cq_tail  = (unsigned *) (cq + params.cq_off.tail);
+  uring->cq_mask  = (unsigned *) (cq + params.cq_off.ring_mask);
+
+  uring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+  return 0;
+}
+
+static void uring_free (uring_t *uring)
+{
+  munmap (uring->sqes,   uring->sqes_size);
+  munmap (uring->cq_ptr, uring->cq_size);
+  munmap (uring->sq_ptr, uring->sq_size);
+
+  close (uring->fd);
+}
+
+static void out_write_uring (out_t *out, out_slot_t *slot, const int slot_idx)
+{
+  uring_t *uring = &out->uring;
+
+  const unsigned tail = *uring->sq_tail;
+  const unsigned idx  = tail & *uring->sq_mask;
+
+  struct io_uring_sqe *sqe = &uring->sqes[idx];
+
+  memset (sqe, 0, sizeof (struct io_uring_sqe));
+
+  sqe->opcode    = IORING_OP_WRITE;
+  sqe->fd        = out->fd;
+  sqe->addr      = (u64) (uintptr_t) slot->buf;
+  sqe->len       = slot->len;
+  sqe->off       = slot->off;
+  sqe->user_data = slot_idx;
+
+  uring->sq_array[idx] = idx;
+
+  __atomic_store_n (uring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  slot->busy = 1;
+
+  while (syscall (__NR_io_uring_enter, uring->fd, 1, 0, 0, NULL, 0) < 0)
+  {
+    if (errno == EINTR) continue;
+
+    exit (-1);
+  }
+}
+
+static void out_reap_uring (out_t *out)
+{
+  uring_t *uring = &out->uring;
+
+  unsigned head = *uring->cq_head;
+
+  while (head == __atomic_load_n (uring->cq_tail, __ATOMIC_ACQUIRE))
+  {
+    if (syscall (__NR_io_uring_enter, uring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0)
+    {
+      if (errno == EINTR) continue;
+
+      exit (-1);
+    }
+  }
+
+  while (head != __atomic_load_n (uring->cq_tail, __ATOMIC_ACQUIRE))
+  {
+    const struct io_uring_cqe *cqe = &uring->cqes[head & *uring->cq_mask];
+
+    out_slot_t *slot = &out->slots[cqe->user_data];
+
+    const int res = cqe->res;
+
+    if (res < 0) exit (-1);
+
+    if (res < slot->len)
+    {
+      // short writes are rare, finish them synchronously
+
+      out_write_pwrite (out, slot->buf + res, slot->len - res, slot->off + res);
+    }
+
+    save_add (slot->cnt);
+
+    slot->busy = 0;
+
+    head++;
+  }
+
+  __atomic_store_n (uring->cq_head, head, __ATOMIC_RELEASE);
+}
+#endif
+
+static void out_write (out_t *out, const int slot_idx)
+{
+  out_slot_t *slot = &out->slots[slot_idx];
+
+  #ifdef LINUX
+  if (out->mode == OUT_MODE_URING)
+  {
+    slot->off = out->off;
+
+    out->off += slot->len;
+
+    out_write_uring (out, slot, slot_idx);
+
+    // save is updated once the write completed
+
+    return;
+  }
+
+  if (out->mode == OUT_MODE_PWRITE)
+  {
+    out_write_pwrite (out, slot->buf, slot->len, out->off);
+
+    out->off += slot->len;
+  }
+  else if (out->mode == OUT_MODE_SPLICE)
+  {
+    out_write_splice (out, slot);
+  }
+  else
+  #endif
+  if (out->lz_threads_cnt)
+  {
+    // stored blocks keep their data in the fill buffer
+
+    const char *payload = (slot->zlen == slot->len) ? slot->buf : slot->zbuf + sizeof (pp_lz_hdr_t);
+
+    if (slot->len)
+    {
+      if ((fwrite (slot->zbuf, 1, sizeof (pp_lz_hdr_t), out->fp) != sizeof (pp_lz_hdr_t))
+       || (fwrite (payload, 1, slot->zlen, out->fp) != (size_t) slot->zlen))
+      {
+        if (ferror (out->fp) == EPIPE) exit (0);
+
+        exit (-1);
+      }
+    }
+  }
+  else
+  {
+    const size_t n = fwrite (slot->buf, 1, slot->len, out->fp);
+
+    if (n != (size_t) slot->len)
+    {
+      const int err = ferror (out->fp);
+
+      if (err == EPIPE)
+      {
+       // out->fp is probably closed
+
+        exit (0);
+      }
+
+      exit (-1);
+    }
+  }
+
+  save_add (slot->cnt);
+}
+
+static int out_slot_ready (const out_t *out)
+{
+  if (out->slots_done == out->slots_fill) return 0;
+
+  // compressed buffers are written in fill order once their worker is done
+
+  if (out->lz_threads_cnt == 0) return 1;
+
+  return out->slots[out->slots_done % out->slots_cnt].zready;
+}
+
+static void *out_thread (void *p)
+{
+  out_t *out = (out_t *) p;
+
+  pthread_mutex_lock (&out->mtx);
+
+  while (1)
+  {
+    while ((out_slot_ready (out) == 0) && ((out->thread_stop == 0) || (out->slots_done < out->slots_fill)))
+    {
+      pthread_cond_wait (&out->cond, &out->mtx);
+    }
+
+    if (out->slots_done == out->slots_fill) break;
+
+    const int slot_idx = out->slots_done % out->slots_cnt;
+
+    pthread_mutex_unlock (&out->mtx);
+
+    // save is shared with the writers of the other lengths, see save_add ()
+
+    out_write (out, slot_idx);
+
+    pthread_mutex_lock (&out->mtx);
+
+    out->slots[slot_idx].zready = 0;
+
+    out->slots_done++;
+
+    pthread_cond_broadcast (&out->cond);
+  }
+
+  pthread_mutex_unlock (&out->mtx);
+
+  return NULL;
+}
+
+static void *out_lz_thread (void *p)
+{
+  out_t *out = (out_t *) p;
+
+  u32 *table = (u32 *) mem_alloc (sizeof (u32) << PP_LZ_HASH_LOG);
+
+  pthread_mutex_lock (&out->mtx);
+
+  while (1)
+  {
+    while ((out->slots_comp == out->slots_fill) && (out->thread_stop == 0))
+    {
+      pthread_cond_wait (&out->cond, &out->mtx);
+    }
+
+    if (out->slots_comp == out->slots_fill) break;
+
+    const int slot_idx = out->slots_comp % out->slots_cnt;
+
+    out->slots_comp++;
+
+    pthread_mutex_unlock (&out->mtx);
+
+    out_slot_t *slot = &out->slots[slot_idx];
+
+    const int zlen = pp_lz_compress ((const u8 *) slot->buf, slot->len, (u8 *) slot->zbuf + sizeof (pp_lz_hdr_t), slot->len - 1, table);
+
+    slot->zlen = (zlen) ? zlen : slot->len;
+
+    pp_lz_hdr_t hdr;
+
+    hdr.magic    = PP_LZ_MAGIC;
+    hdr.version  = PP_LZ_VERSION;
+    hdr.format   = out->format;
+    hdr.raw_len  = slot->len;
+    hdr.comp_len = slot->zlen;
+    hdr.cnt      = slot->cnt;
+    hdr.pos[0]   = (u64) (slot->pos >>  0);
+    hdr.pos[1]   = (u64) (slot->pos >> 64);
+
+    memcpy (slot->zbuf, &hdr, sizeof (hdr));
+
+    pthread_mutex_lock (&out->mtx);
+
+    slot->zready = 1;
+
+    pthread_cond_broadcast (&out->cond);
+  }
+
+  pthread_mutex_unlock (&out->mtx);
+
+  free (table);
+
+  return NULL;
+}
+
+static void out_thread_create (pthread_t *thread, void *(*start) (void *), out_t *out)
+{
+  // make sure SIGINT is handled by the generating thread
+
+  sigset_t set;
+  sigset_t set_old;
+
+  sigemptyset (&set);
+  sigaddset (&set, SIGINT);
+
+  pthread_sigmask (SIG_BLOCK, &set, &set_old);
+
+  if (pthread_create (thread, NULL, start, out) != 0)
+  {
+    fprintf (stderr, "pthread_create: %s\n", strerror (errno));
+
+    exit (-1);
+  }
+
+  pthread_sigmask (SIG_SETMASK, &set_old, NULL);
+}
+
+static void out_init (out_t *out, FILE *fp, const int writer_thread, const int splice, const int uring)
+{
+  out->fp       = fp;
+  out->fd       = -1;
+  out->mode     = OUT_MODE_STDIO;
+  out->off      = 0;
+  out->len      = 0;
+  out->cnt      = 0;
+  out->rec_max  = OUT_REC_MAX;
+  out->prev_len = 0;
+  out->parent   = NULL;
+
+  out->lz_threads_cnt = 0;
+
+  out->slots_fill = 0;
+  out->slots_done = 0;
+
+  out->size = (writer_thread) ? OUT_BUF_SIZE_THR : OUT_BUF_SIZE;
+
+  int use_thread = writer_thread;
+
+  #ifdef LINUX
+  const int fd = fileno (fp);
+
+  struct stat st;
+
+  if (fstat (fd, &st) == -1)
+  {
+    fprintf (stderr, "fstat: %s\n", strerror (errno));
+
+    exit (-1);
+  }
+
+  if (splice && S_ISFIFO (st.st_mode))
+  {
+    fflush (fp);
+
+    fcntl (fd, F_SETPIPE_SZ, OUT_PIPE_SIZE);
+
+    const int pipe_size = fcntl (fd, F_GETPIPE_SZ);
+
+    if (pipe_size > 0)
+    {
+      // buffers of half the pipe size, one can be filled while the
+      // other one is still in the pipe
+
+      out->fd   = fd;
+      out->mode = OUT_MODE_SPLICE;
+      out->size = pipe_size / 2;
+    }
+  }
+
+  if (uring && S_ISREG (st.st_mode))
+  {
+    fflush (fp);
+
+    // the file was opened for appending, but with several writes in flight
+    // we have to place them ourself
+
+    fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) & ~O_APPEND);
+
+    const off_t off = lseek (fd, 0, SEEK_END);
+
+    if (off == -1)
+    {
+      fprintf (stderr, "lseek: %s\n", strerror (errno));
+
+      exit (-1);
+    }
+
+    out->fd   = fd;
+    out->off  = off;
+    out->mode = (uring_init (&out->uring, OUT_BUFS_MAX) == 0) ? OUT_MODE_URING : OUT_MODE_PWRITE;
+    out->size = OUT_BUF_SIZE_URI;
+
+    // the kernel does the async part
+
+    use_thread = 0;
+  }
+  #else
+  (void) splice;
+  (void) uring;
+  #endif
+
+  if (out->mode == OUT_MODE_URING)
+  {
+    out->slots_cnt = OUT_BUFS_MAX;
+  }
+  else
+  {
+    out->slots_cnt = 1 + ((use_thread) ? 1 : 0);
+  }
+
+  for (int i = 0; i < out->slots_cnt; i++)
+  {
+    #ifdef LINUX
+    if (out->fd != -1)
+    {
+      // page aligned and never touched by malloc() after release
+
+      out->slots[i].buf = mmap (NULL, out->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+      if (out->slots[i].buf == MAP_FAILED)
+      {
+        fprintf (stderr, "mmap: %s\n", strerror (errno));
+
+        exit (-1);
+      }
+    }
+    else
+    #endif
+    {
+      out->slots[i].buf = mem_alloc (out->size);
+    }
+
+    out->slots[i].len  = 0;
+    out->slots[i].cnt  = 0;
+    out->slots[i].busy = 0;
+    out->slots[i].off  = 0;
+  }
+
+  out->buf = out->slots[0].buf;
+
+  out->thread_active = 0;
+  out->thread_stop   = 0;
+
+  if (use_thread)
+  {
+    pthread_mutex_init (&out->mtx, NULL);
+    pthread_cond_init  (&out->cond, NULL);
+
+    out_thread_create (&out->thread, out_thread, out);
+
+    out->thread_active = 1;
+  }
+}
+
+static void out_init_compress (out_t *out, FILE *fp, const int threads_cnt, const int format, const mpz_t pos)
+{
+  out->fp       = fp;
+  out->fd       = -1;
+  out->mode     = OUT_MODE_STDIO;
+  out->off      = 0;
+  out->len      = 0;
+  out->cnt      = 0;
+  out->rec_max  = OUT_REC_MAX;
+  out->prev_len = 0;
+  out->parent   = NULL;
+  out->format   = format;
+
+  mpz_init_set (out->pos, pos);
+
+  out->slots_fill = 0;
+  out->slots_done = 0;
+  out->slots_comp = 0;
+
+  // one buffer being filled, one being written, one per worker
+
+  out->size      = OUT_BUF_SIZE_LZ;
+  out->slots_cnt = threads_cnt + 2;
+
+  for (int i = 0; i < out->slots_cnt; i++)
+  {
+    out->slots[i].buf    = mem_alloc (out->size);
+    out->slots[i].zbuf   = mem_alloc (sizeof (pp_lz_hdr_t) + out->size);
+    out->slots[i].len    = 0;
+    out->slots[i].cnt    = 0;
+    out->slots[i].busy   = 0;
+    out->slots[i].off    = 0;
+    out->slots[i].zready = 0;
+  }
+
+  out->buf = out->slots[0].buf;
+
+  out->thread_stop    = 0;
+  out->lz_threads_cnt = threads_cnt;
+
+  pthread_mutex_init (&out->mtx, NULL);
+  pthread_cond_init  (&out->cond, NULL);
+
+  out_thread_create (&out->thread, out_thread, out);
+
+  out->thread_active = 1;
+
+  for (int i = 0; i < threads_cnt; i++)
+  {
+    out_thread_create (&out->lz_threads[i], out_lz_thread, out);
+  }
+}
+
+#ifdef LINUX
+static void out_mmap_window (out_t *out)
+{
+  if (out->map_ptr)
+  {
+    munmap (out->map_ptr, out->map_size);
+
+    out->map_ptr = NULL;
+  }
+
+  out->buf  = NULL;
+  out->size = 0;
+
+  const u64 page_size = sysconf (_SC_PAGESIZE);
+
+  const u64 map_beg = out->off & ~(page_size - 1);
+  const u64 map_end = MIN (map_beg + OUT_MMAP_WINDOW, out->map_end);
+
+  if (map_end == out->off) return;
+
+  out->map_size = map_end - map_beg;
+
+  out->map_ptr = mmap (NULL, out->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, out->fd, map_beg);
+
+  if (out->map_ptr == MAP_FAILED)
+  {
+    fprintf (stderr, "mmap: %s\n", strerror (errno));
+
+    exit (-1);
+  }
+
+  madvise (out->map_ptr, out->map_size, MADV_SEQUENTIAL);
+
+  out->buf  = out->map_ptr + (out->off - map_beg);
+  out->size = map_end - out->off;
+}
+
+static void out_init_mmap (out_t *out, FILE *fp, const u64 out_size)
+{
+  out->fp       = fp;
+  out->fd       = fileno (fp);
+  out->mode     = OUT_MODE_MMAP;
+  out->len      = 0;
+  out->cnt      = 0;
+  out->rec_max  = OUT_REC_MAX;
+  out->prev_len = 0;
+  out->parent   = NULL;
+
+  out->slots_cnt      = 0;
+  out->thread_active  = 0;
+  out->lz_threads_cnt = 0;
+
+  const off_t off = lseek (out->fd, 0, SEEK_END);
+
+  if (off == -1)
+  {
+    fprintf (stderr, "lseek: %s\n", strerror (errno));
+
+    exit (-1);
+  }
+
+  out->off     = off;
+  out->map_ptr = NULL;
+  out->map_end = off + out_size;
+
+  if (out_size)
+  {
+    if (fallocate (out->fd, 0, off, out_size) == -1)
+    {
+      if ((errno != EOPNOTSUPP) || (ftruncate (out->fd, out->map_end) == -1))
+      {
+        fprintf (stderr, "fallocate: %s\n", strerror (errno));
+
+        exit (-1);
+      }
+    }
+  }
+
+  out_mmap_window (out);
+}
+#endif
+
+#ifdef LINUX
+static int out_shm_wait (const u64 *seq, const u64 val)
+{
+  for (int spins = 0; __atomic_load_n (seq, __ATOMIC_ACQUIRE) != val; spins++)
+  {
+    // no consumer may ever come, an interrupt has to get through
+
+    if (stop_sig) return -1;
+
+    if (spins < 100)
+    {
+      sched_yield ();
+    }
+    else
+    {
+      const struct timespec ts = { 0, 50000 };
+
+      nanosleep (&ts, NULL);
+    }
+  }
+
+  return 0;
+}
+
+static void out_shm_block (out_t *out)
+{
+  // wait for the consumers to release the slot we fill next
+
+  const u64 slot_idx = out->shm_seq % PP_SHM_BLOCKS;
+
+  out->size = PP_SHM_BLOCK_RECS * sizeof (pw_t);
+
+  if (out_shm_wait (&out->shm_blocks[slot_idx].free_seq, out->shm_seq) == -1)
+  {
+    // the main loop finishes its chain segment into a buffer that is never
+    // published, save only counts published blocks and stays exact
+
+    if (out->shm_scratch == NULL) out->shm_scratch = mem_alloc (out->size);
+
+    out->buf = out->shm_scratch;
+
+    return;
+  }
+
+  out->buf = out->shm_data + slot_idx * PP_SHM_BLOCK_RECS * sizeof (pw_t);
+}
+
+static void out_init_shm (out_t *out, const char *name)
+{
+  out->fp       = NULL;
+  out->mode     = OUT_MODE_SHM;
+  out->len      = 0;
+  out->cnt      = 0;
+  out->rec_max  = OUT_REC_MAX;
+  out->prev_len = 0;
+  out->parent   = NULL;
+
+  out->slots_cnt      = 0;
+  out->thread_active  = 0;
+  out->lz_threads_cnt = 0;
+
+  // never hand a stale ring from an earlier run to new consumers
+
+  shm_unlink (name);
+
+  out->shm_name = name;
+
+  out->fd = shm_open (name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+  if (out->fd == -1)
+  {
+    fprintf (stderr, "%s: %s\n", name, strerror (errno));
+
+    exit (-1);
+  }
+
+  out->shm_size = pp_shm_size (PP_SHM_BLOCKS, PP_SHM_BLOCK_RECS);
+
+  if (ftruncate (out->fd, out->shm_size) == -1)
+  {
+    fprintf (stderr, "%s: %s\n", name, strerror (errno));
+
+    exit (-1);
+  }
+
+  char *ptr = mmap (NULL, out->shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, out->fd, 0);
+
+  if (ptr == MAP_FAILED)
+  {
+    fprintf (stderr, "mmap: %s\n", strerror (errno));
+
+    exit (-1);
+  }
+
+  out->shm_hdr     = (pp_shm_hdr_t *)   ptr;
+  out->shm_blocks  = (pp_shm_block_t *) (ptr + pp_shm_blocks_off ());
+  out->shm_data    = ptr + pp_shm_data_off (PP_SHM_BLOCKS);
+  out->shm_seq     = 0;
+  out->shm_scratch = NULL;
+
+  for (u32 i = 0; i < PP_SHM_BLOCKS; i++)
+  {
+    out->shm_blocks[i].ready_seq = 0;
+    out->shm_blocks[i].free_seq  = i;
+    out->shm_blocks[i].cnt       = 0;
+  }
+
+  out->shm_hdr->version    = PP_SHM_VERSION;
+  out->shm_hdr->blocks_cnt = PP_SHM_BLOCKS;
+  out->shm_hdr->block_recs = PP_SHM_BLOCK_RECS;
+  out->shm_hdr->rec_size   = sizeof (pw_t);
+  out->shm_hdr->done       = 0;
+  out->shm_hdr->head       = 0;
+  out->shm_hdr->claim      = 0;
+  out->shm_hdr->pid        = (u32) getpid ();
+
+  __atomic_store_n (&out->shm_hdr->magic, PP_SHM_MAGIC, __ATOMIC_RELEASE);
+
+  out_shm_block (out);
+}
+#endif
+
+static void out_init_block (out_t *out, out_t *parent, const int pw_len, const int rec_len, const int block_cnt)
+{
+  out->fp       = NULL;
+  out->fd       = -1;
+  out->mode     = OUT_MODE_BLOCK;
+  out->len      = 0;
+  out->cnt      = 0;
+  out->size     = block_cnt * rec_len;
+  out->rec_max  = rec_len;
+  out->prev_len = 0;
+  out->parent   = parent;
+  out->pw_len   = pw_len;
+
+  out->slots_cnt      = 0;
+  out->thread_active  = 0;
+  out->lz_threads_cnt = 0;
+
+  out->buf = mem_alloc (out->size);
+}
+
+static void out_init_worker (out_t *out, FILE *fp)
+{
+  // one per --unordered worker, which also writes it. stdio locks the
+  // stream for each fwrite (), so the buffers of two workers never mix
+
+  out->fp       = fp;
+  out->fd       = -1;
+  out->mode     = OUT_MODE_STDIO;
+  out->off      = 0;
+  out->len      = 0;
+  out->cnt      = 0;
+  out->rec_max  = OUT_REC_MAX;
+  out->prev_len = 0;
+  out->parent   = NULL;
+
+  out->lz_threads_cnt = 0;
+
+  out->slots_fill = 0;
+  out->slots_done = 0;
+
+  out->size      = OUT_BUF_SIZE_THR;
+  out->slots_cnt = 1;
+
+  out->slots[0].buf  = mem_alloc (out->size);
+  out->slots[0].len  = 0;
+  out->slots[0].cnt  = 0;
+  out->slots[0].busy = 0;
+  out->slots[0].off  = 0;
+
+  out->buf = out->slots[0].buf;
+
+  out->thread_active = 0;
+  out->thread_stop   = 0;
+}
+
+static void out_close (out_t *out)
+{
+  if (out->thread_active)
+  {
+    pthread_mutex_lock (&out->mtx);
+
+    out->thread_stop = 1;
+
+    pthread_cond_broadcast (&out->cond);
+
+    pthread_mutex_unlock (&out->mtx);
+
+    pthread_join (out->thread, NULL);
+
+    for (int i = 0; i < out->lz_threads_cnt; i++)
+    {
+      pthread_join (out->lz_threads[i], NULL);
+    }
+
+    pthread_mutex_destroy (&out->mtx);
+    pthread_cond_destroy  (&out->cond);
+
+    out->thread_active = 0;
+  }
+
+  if (out->mode == OUT_MODE_BLOCK)
+  {
+    free (out->buf);
+
+    return;
+  }
+
+  #ifdef LINUX
+  if (out->mode == OUT_MODE_URING)
+  {
+    for (int i = 0; i < out->slots_cnt; i++)
+    {
+      while (out->slots[i].busy) out_reap_uring (out);
+    }
+
+    uring_free (&out->uring);
+  }
+
+  if (out->mode == OUT_MODE_MMAP)
+  {
+    if (out->map_ptr) munmap (out->map_ptr, out->map_size);
+
+    out->map_ptr = NULL;
+
+    // drop the preallocated space we did not get to after a stop
+
+    if (out->off < out->map_end)
+    {
+      if (ftruncate (out->fd, out->off) == -1) exit (-1);
+    }
+
+    return;
+  }
+
+  if (out->mode == OUT_MODE_SHM)
+  {
+    // consumers still attached keep the object alive until they unmap it
+
+    __atomic_store_n (&out->shm_hdr->done, 1, __ATOMIC_RELEASE);
+
+    munmap (out->shm_hdr, out->shm_size);
+
+    close (out->fd);
+
+    shm_unlink (out->shm_name);
+
+    free (out->shm_scratch);
+
+    return;
+  }
+  #endif
+
+  for (int i = 0; i < out->slots_cnt; i++)
+  {
+    #ifdef LINUX
+    if (out->fd != -1)
+    {
+      munmap (out->slots[i].buf, out->size);
+
+      continue;
+    }
+    #endif
+
+    free (out->slots[i].buf);
+
+    if (out->lz_threads_cnt) free (out->slots[i].zbuf);
+  }
+}
+
+static void out_append (out_t *out, const char *buf, int len, const u64 cnt);
+
+static void out_flush (out_t *out)
+{
+  if (out->mode == OUT_MODE_BLOCK)
+  {
+    if (out->cnt == 0) return;
+
+    out_block_hdr_t hdr;
+
+    hdr.pw_len = out->pw_len;
+    hdr.cnt    = out->cnt;
+
+    out_append (out->parent, (const char *) &hdr, sizeof (hdr), 0);
+    out_append (out->parent, out->buf, out->len, out->cnt);
+
+    out->len = 0;
+    out->cnt = 0;
+
+    return;
+  }
+
+  #ifdef LINUX
+  if (out->mode == OUT_MODE_MMAP)
+  {
+    // candidates are already in place
+
+    out->off += out->len;
+
+    save_add (out->cnt);
+
+    out_mmap_window (out);
+
+    out->len = 0;
+    out->cnt = 0;
+
+    return;
+  }
+
+  if (out->mode == OUT_MODE_SHM)
+  {
+    if (out->cnt == 0) return;
+
+    if (out->buf == out->shm_scratch)
+    {
+      out->len = 0;
+      out->cnt = 0;
+
+      return;
+    }
+
+    pp_shm_block_t *block = &out->shm_blocks[out->shm_seq % PP_SHM_BLOCKS];
+
+    block->cnt = out->cnt;
+
+    out->shm_seq++;
+
+    __atomic_store_n (&block->ready_seq,   out->shm_seq, __ATOMIC_RELEASE);
+    __atomic_store_n (&out->shm_hdr->head, out->shm_seq, __ATOMIC_RELEASE);
+
+    save_add (out->cnt);
+
+    out->len = 0;
+    out->cnt = 0;
+
+    out_shm_block (out);
+
+    return;
+  }
+  #endif
+
+  out_slot_t *slot = &out->slots[out->slots_fill % out->slots_cnt];
+
+  slot->len = out->len;
+  slot->cnt = out->cnt;
+
+  if (out->lz_threads_cnt)
+  {
+    mpz_set (slot->pos, out->pos);
+
+    mpz_add_ui (out->pos, out->pos, out->cnt);
+
+    // every block has to decode on its own
+
+    out->prev_len = 0;
+  }
+
+  if (out->thread_active)
+  {
+    pthread_mutex_lock (&out->mtx);
+
+    out->slots_fill++;
+
+    pthread_cond_broadcast (&out->cond);
+
+    // wait until the writer has drained the buffer we fill next
+
+    while (out->slots_done + out->slots_cnt <= out->slots_fill)
+    {
+      pthread_cond_wait (&out->cond, &out->mtx);
+    }
+
+    pthread_mutex_unlock (&out->mtx);
+  }
+  else
+  {
+    out_write (out, out->slots_fill % out->slots_cnt);
+
+    out->slots_fill++;
+    out->slots_done++;
+  }
+
+  const int slot_idx = out->slots_fill % out->slots_cnt;
+
+  #ifdef LINUX
+  while (out->slots[slot_idx].busy) out_reap_uring (out);
+  #endif
+
+  out->buf = out->slots[slot_idx].buf;
+
+  out->len = 0;
+  out->cnt = 0;
+}
+
+static void out_push_front (out_t *out, const char *pw_buf, const int pw_len)
+{
+  // Chains vary their first element fastest, so a candidate mostly differs
+  // from the previous one in a few bytes somewhere in its first element.
+  // Each record holds the number of bytes kept from the start (pre) and the
+  // end (suf) of the previous candidate and only the bytes in between:
+  //
+  //   (pre << 4) | mid                      same length, pre < 15, mid < 16
+  //   0xff, pw_len, pre, suf                otherwise
+  //
+  // The first record of a stream never refers to anything before it, so
+  // the output of a resumed session can be appended to an existing file.
+
+  const char *prev = out->prev;
+
+  const int prev_len = out->prev_len;
+
+  const int cmp_len = MIN (pw_len, prev_len);
+
+  int suf = 0;
+
+  while ((suf < cmp_len) && (pw_buf[pw_len - 1 - suf] == prev[prev_len - 1 - suf])) suf++;
+
+  int pre = 0;
+
+  while ((pre < cmp_len - suf) && (pw_buf[pre] == prev[pre])) pre++;
+
+  const int mid = pw_len - pre - suf;
+
+  char *ptr = out->buf + out->len;
+
+  if ((pw_len == prev_len) && (pre < 15) && (mid < 16))
+  {
+    *ptr++ = (char) ((pre << 4) | mid);
+  }
+  else
+  {
+    *ptr++ = (char) 0xff;
+    *ptr++ = (char) pw_len;
+    *ptr++ = (char) pre;
+    *ptr++ = (char) suf;
+  }
+
+  memcpy (ptr, pw_buf + pre, mid);
+
+  out->len = ptr + mid - out->buf;
+
+  memcpy (out->prev + pre, pw_buf + pre, pw_len - pre);
+
+  out->prev_len = pw_len;
+
+  out->cnt++;
+
+  if (out->len > out->size - out->rec_max)
+  {
+    out_flush (out);
+  }
+}
+
+static void out_append (out_t *out, const char *buf, int len, const u64 cnt)
+{
+  // bulk data may span several output buffers
+
+  while (len)
+  {
+    const int copy_len = MIN (len, out->size - out->len);
+
+    memcpy (out->buf + out->len, buf, copy_len);
+
+    out->len += copy_len;
+
+    buf += copy_len;
+    len -= copy_len;
+
+    if (len) out_flush (out);
+  }
+
+  out->cnt += cnt;
+
+  if (out->len > out->size - out->rec_max)
+  {
+    out_flush (out);
+  }
+}
+
+static int out_rec_off (const int out_format)
+{
+  return (out_format == OUT_FORMAT_LEN8) ? 1 : 0;
+}
+
+static int out_rec_len (const int out_format, const int out_stride, const int pw_len)
+{
+  if (out_format == OUT_FORMAT_FIXED) return out_stride;
+  if (out_format == OUT_FORMAT_PW_T)  return sizeof (pw_t);
+  if (out_format == OUT_FORMAT_FRONT) return pw_len + 4;
+
+  return pw_len + 1;
+}
+
+static int out_rec_init (char *rec_buf, const int out_format, const int out_stride, const int pw_len)
+{
+  // everything around the candidate stays constant for a given length
+
+  switch (out_format)
+  {
+    case OUT_FORMAT_PLAIN:  rec_buf[pw_len] = '\n';                             break;
+    case OUT_FORMAT_NUL:    rec_buf[pw_len] = 0;                                break;
+    case OUT_FORMAT_LEN8:   rec_buf[0] = (char) pw_len;                         break;
+    case OUT_FORMAT_FIXED:  memset (rec_buf + pw_len, 0, out_stride - pw_len);  break;
+    case OUT_FORMAT_FRONT:                                                      break;
+    case OUT_FORMAT_PW_T:
+    {
+      const u32 len = pw_len;
+
+      memset (rec_buf + pw_len, 0, offsetof (pw_t, pw_len) - pw_len);
+
+      memcpy (rec_buf + offsetof (pw_t, pw_len), &len, sizeof (len));
+
+      break;
+    }
+  }
+
+  return out_rec_len (out_format, out_stride, pw_len);
+}
+
+static int sort_by_cnt (const void *p1, const void *p2)
+{
+  const pw_order_t *o1 = (const pw_order_t *) p1;
+  const pw_order_t *o2 = (const pw_order_t *) p2;
+
+  // Descending order
+  if (o1->cnt > o2->cnt) return -1;
+  if (o1->cnt < o2->cnt) return  1;
+
+  return 0;
+}
+
+static int sort_by_ks (const void *p1, const void *p2)
+{
+  const chain_t *f1 = (const chain_t *) p1;
+  const chain_t *f2 = (const chain_t *) p2;
+
+  return mpz_cmp (f1->ks_cnt, f2->ks_cnt);
+}
+
+static int chain_valid_with_db (const chain_t *chain_buf, const db_entry_t *db_entries)
+{
+  const u8 *buf = chain_buf->buf;
+  const int cnt = chain_buf->cnt;
+
+  for (int idx = 0; idx < cnt; idx++)
+  {
+    const u8 db_key = buf[idx];
+
+    const db_entry_t *db_entry = &db_entries[db_key];
+
+    if (db_entry->elems_cnt == 0) return 0;
+  }
+
+  return 1;
+}
+
+static int chain_valid_with_cnt_min (const chain_t *chain_buf, const int elem_cnt_min)
+{
+  const int cnt = chain_buf->cnt;
+
+  if (cnt < elem_cnt_min) return 0;
+
+  return 1;
+}
+
+static int chain_valid_with_cnt_max (const chain_t *chain_buf, const int elem_cnt_max)
+{
+  const int cnt = chain_buf->cnt;
+
+  if (cnt > elem_cnt_max) return 0;
+
+  return 1;
+}
+
+static void chain_ks (const chain_t *chain_buf, const db_entry_t *db_entries, mpz_t *ks_cnt)
+{
+  const u8 *buf = chain_buf->buf;
+  const int cnt = chain_buf->cnt;
+
+  mpz_set_si (*ks_cnt, 1);
+
+  for (int idx = 0; idx < cnt; idx++)
+  {
+    const u8 db_key = buf[idx];
+
+    const db_entry_t *db_entry = &db_entries[db_key];
+
+    const u64 elems_cnt = db_entry->elems_cnt;
+
+    mpz_mul_ui (*ks_cnt, *ks_cnt, elems_cnt);
+  }
+}
+
+static u64 chain_tile_cnt (const chain_t *chain_buf, const db_entry_t *db_entries)
+{
+  // number of first elements in a tile of --order-tile bytes, 0 if the
+  // chain is walked in the plain order
+
+  if (order_tile == 0) return 0;
+
+  if (chain_buf->cnt < 2) return 0;
+
+  const db_entry_t *db_entry = &db_entries[chain_buf->buf[0]];
+
+  u64 tile_cnt = order_tile / db_entry->elems_stride;
+
+  if (tile_cnt == 0) tile_cnt = 1;
+
+  if (tile_cnt >= db_entry->elems_cnt) return 0;
+
+  return tile_cnt;
+}
+
+static void set_chain_ks_poses (const chain_t *chain_buf, const db_entry_t *db_entries, mpz_t *tmp, u64 cur_chain_ks_poses[OUT_LEN_MAX])
+{
+  const u8 *buf = chain_buf->buf;
+
+  const int cnt = chain_buf->cnt;
+
+  int idx = 0;
+
+  const u64 tile_cnt = chain_tile_cnt (chain_buf, db_entries);
+
+  if (tile_cnt)
+  {
+    // With --order-tile the first element runs through one tile, then the
+    // second element moves, and only once all second elements are done the
+    // next tile of first elements follows. The following elements keep the
+    // plain mixed radix order on top of that.
+
+    const u64 elems_cnt0 = db_entries[buf[0]].elems_cnt;
+    const u64 elems_cnt1 = db_entries[buf[1]].elems_cnt;
+
+    mpz_t plane; mpz_init_set_ui (plane, elems_cnt0);
+
+    mpz_mul_ui (plane, plane, elems_cnt1);
+
+    const u64 plane_pos = mpz_fdiv_ui (*tmp, plane);
+
+    mpz_div_ui (*tmp, *tmp, plane);
+
+    mpz_clear (plane);
+
+    const u64 tile_beg = plane_pos / (tile_cnt * elems_cnt1) * tile_cnt;
+
+    const u64 tile_pos = plane_pos - tile_beg * elems_cnt1;
+
+    const u64 tile_len = MIN (tile_cnt, elems_cnt0 - tile_beg);
+
+    cur_chain_ks_poses[0] = tile_beg + tile_pos % tile_len;
+    cur_chain_ks_poses[1] = tile_pos / tile_len;
+
+    idx = 2;
+  }
+
+  for (; idx < cnt; idx++)
+  {
+    const u8 db_key = buf[idx];
+
+    const db_entry_t *db_entry = &db_entries[db_key];
+
+    const u64 elems_cnt = db_entry->elems_cnt;
+
+    cur_chain_ks_poses[idx] = mpz_fdiv_ui (*tmp, elems_cnt);
+
+    mpz_div_ui (*tmp, *tmp, elems_cnt);
+  }
+}
+
+static u64 ks_left_u64 (const mpz_t ks_cnt, const mpz_t ks_pos)
+{
+  // saturates at UINT64_MAX, callers recompute it from the 128-bit position
+  // instead of counting down from a saturated value
+
+  mpz_t tmp; mpz_init (tmp);
+
+  mpz_sub (tmp, ks_cnt, ks_pos);
+
+  const u64 left = (mpz_cmp_ui (tmp, UINT64_MAX) < 0) ? (u64) mpz_get_ui (tmp) : UINT64_MAX;
+
+  mpz_clear (tmp);
+
+  return left;
+}
+
+static prefix_t *prefixes_hash[PREFIXES_HASH_SIZE];
+
+static u64 prefixes_size = 0;
+
+static pthread_mutex_t prefixes_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static const prefix_t *prefix_get (const db_entry_t *db_entries, const u8 *key, const int key_cnt)
+{
+  // Precomposed prefixes are shared by all chains starting with the same
+  // element lengths. Entry i holds the elements at the mixed radix
+  // position i, first element fastest, already concatenated.
+
+  u32 h = 0x811c9dc5;
+
+  for (int idx = 0; idx < key_cnt; idx++) h = (h ^ key[idx]) * 0x01000193;
+
+  pthread_mutex_lock (&prefixes_mtx);
+
+  const prefix_t *res = NULL;
+
+  for (u32 probe = 0; probe < PREFIXES_HASH_SIZE; probe++)
+  {
+    prefix_t **slot = &prefixes_hash[(h + probe) & (PREFIXES_HASH_SIZE - 1)];
+
+    prefix_t *prefix = *slot;
+
+    if (prefix)
+    {
+      if ((prefix->key_cnt == key_cnt) && (memcmp (prefix->key, key, key_cnt) == 0))
+      {
+        res = prefix;
+
+        break;
+      }
+
+      continue;
+    }
+
+    u64 cnt = 1;
+    int len = 0;
+
+    for (int idx = 0; idx < key_cnt; idx++)
+    {
+      cnt *= db_entries[key[idx]].elems_cnt;
+      len += key[idx];
+    }
+
+    if (prefixes_size + cnt * len > PREFIXES_SIZE_MAX) break;
+
+    prefix = (prefix_t *) mem_alloc (sizeof (prefix_t));
+
+    memcpy (prefix->key, key, key_cnt);
+
+    prefix->key_cnt = key_cnt;
+    prefix->cnt     = cnt;
+    prefix->len     = len;
+    prefix->buf     = (u8 *) mem_alloc (cnt * len + PP_SIMD_PAD);
+
+    u64 poses[OUT_LEN_MAX];
+
+    memset (poses, 0, sizeof (poses));
+
+    for (u64 i = 0; i < cnt; i++)
+    {
+      u8 *ptr = prefix->buf + i * len;
+
+      for (int idx = 0; idx < key_cnt; idx++)
+      {
+        const db_entry_t *db_entry = &db_entries[key[idx]];
+
+        memcpy (ptr, db_entry->elems_buf + poses[idx] * db_entry->elems_stride, key[idx]);
+
+        ptr += key[idx];
+      }
+
+      for (int idx = 0; idx < key_cnt; idx++)
+      {
+        if (++poses[idx] < db_entries[key[idx]].elems_cnt) break;
+
+        poses[idx] = 0;
+      }
+    }
+
+    prefixes_size += cnt * len;
+
+    *slot = prefix;
+
+    res = prefix;
+
+    break;
+  }
+
+  pthread_mutex_unlock (&prefixes_mtx);
+
+  return res;
+}
+
+static void prefixes_free (void)
+{
+  for (int i = 0; i < PREFIXES_HASH_SIZE; i++)
+  {
+    if (prefixes_hash[i] == NULL) continue;
+
+    free (prefixes_hash[i]->buf);
+    free (prefixes_hash[i]);
+
+    prefixes_hash[i] = NULL;
+  }
+}
+
+static void chain_kern_init (chain_kern_t *chain_kern, const chain_t *chain_buf, const db_entry_t *db_entries, const u64 cur_chain_ks_poses[OUT_LEN_MAX])
+{
+  // everything the copy loops need for this chain, picked once when the
+  // chain becomes active instead of for every candidate
+
+  const u8 *buf = chain_buf->buf;
+
+  const int cnt = chain_buf->cnt;
+
+  // With short element lists the first element wraps every few
+  // candidates, each time ending a run and carrying into the following
+  // elements with several tiny copies. As many leading elements as fit in
+  // PREFIX_SIZE_MAX are replaced by a single precomposed prefix, which then
+  // acts as one long running first element with a mixed radix position.
+
+  // Tiled chains keep the real first element, the tiles are cut from it
+
+  const u64 tile_cnt = chain_tile_cnt (chain_buf, db_entries);
+
+  int prefix_cnt = 0;
+
+  u64 prefix_size = 1;
+
+  int prefix_len = 0;
+
+  for (int idx = 0; (idx < cnt) && (tile_cnt == 0); idx++)
+  {
+    const u8 db_key = buf[idx];
+
+    const u64 elems_cnt = db_entries[db_key].elems_cnt;
+
+    if (prefix_size * elems_cnt * (prefix_len + db_key) > PREFIX_SIZE_MAX) break;
+
+    prefix_size *= elems_cnt;
+    prefix_len  += db_key;
+
+    prefix_cnt++;
+  }
+
+  const prefix_t *prefix = (prefix_cnt >= 2) ? prefix_get (db_entries, buf, prefix_cnt) : NULL;
+
+  if (prefix == NULL) prefix_cnt = 0;
+
+  int kern_idx = 0;
+
+  for (int idx = 0; idx < cnt; idx++)
+  {
+    const u8 db_key = buf[idx];
+
+    const db_entry_t *db_entry = &db_entries[db_key];
+
+    if ((idx == 0) && prefix_cnt)
+    {
+      u64 pos   = 0;
+      u64 radix = 1;
+
+      for (int i = 0; i < prefix_cnt; i++)
+      {
+        chain_kern->prefix_radix[i] = db_entries[buf[i]].elems_cnt;
+
+        pos += cur_chain_ks_poses[i] * radix;
+
+        radix *= chain_kern->prefix_radix[i];
+      }
+
+      chain_kern->copy[kern_idx]         = pp_copy_tab[prefix->len];
+      chain_kern->elems_buf[kern_idx]    = prefix->buf;
+      chain_kern->elems_stride[kern_idx] = prefix->len;
+      chain_kern->elems_cnt[kern_idx]    = prefix->cnt;
+      chain_kern->len[kern_idx]          = prefix->len;
+      chain_kern->poses[kern_idx]        = pos;
+
+      kern_idx++;
+
+      idx += prefix_cnt - 1;
+
+      continue;
+    }
+
+    chain_kern->copy[kern_idx]         = pp_copy_tab[db_key];
+    chain_kern->elems_buf[kern_idx]    = db_entry->elems_buf;
+    chain_kern->elems_stride[kern_idx] = db_entry->elems_stride;
+    chain_kern->elems_cnt[kern_idx]    = db_entry->elems_cnt;
+    chain_kern->len[kern_idx]          = db_key;
+    chain_kern->poses[kern_idx]        = cur_chain_ks_poses[idx];
+
+    kern_idx++;
+  }
+
+  chain_kern->cnt        = kern_idx;
+  chain_kern->prefix_cnt = prefix_cnt;
+
+  chain_kern->jit_done = 0;
+  chain_kern->jit_fn   = NULL;
+
+  chain_kern->tile_cnt = tile_cnt;
+  chain_kern->tile_beg = 0;
+  chain_kern->tile_end = chain_kern->elems_cnt[0];
+
+  if (tile_cnt)
+  {
+    chain_kern->tile_beg = chain_kern->poses[0] / tile_cnt * tile_cnt;
+    chain_kern->tile_end = MIN (chain_kern->tile_beg + tile_cnt, chain_kern->elems_cnt[0]);
+  }
+}
+
+static void chain_kern_save (const chain_kern_t *chain_kern, u64 cur_chain_ks_poses[OUT_LEN_MAX])
+{
+  // back to one position per element of the chain
+
+  const int prefix_cnt = chain_kern->prefix_cnt;
+
+  int idx = 0;
+
+  for (int kern_idx = 0; kern_idx < chain_kern->cnt; kern_idx++)
+  {
+    if ((kern_idx == 0) && prefix_cnt)
+    {
+      u64 pos = chain_kern->poses[kern_idx];
+
+      for (int i = 0; i < prefix_cnt; i++)
+      {
+        cur_chain_ks_poses[idx++] = pos % chain_kern->prefix_radix[i];
+
+        pos /= chain_kern->prefix_radix[i];
+      }
+
+      continue;
+    }
+
+    cur_chain_ks_poses[idx++] = chain_kern->poses[kern_idx];
+  }
+}
+
+static void chain_set_pwbuf_init (const chain_kern_t *chain_kern, char *pw_buf)
+{
+  const int cnt = chain_kern->cnt;
+
+  for (int idx = 0; idx < cnt; idx++)
+  {
+    const u64 elems_idx = chain_kern->poses[idx];
+
+    chain_kern->copy[idx] ((u8 *) pw_buf, chain_kern->elems_buf[idx] + elems_idx * chain_kern->elems_stride[idx]);
+
+    pw_buf += chain_kern->len[idx];
+  }
+}
+
+static int chain_set_pwbuf_increment_tiled (chain_kern_t *chain_kern, char *pw_buf)
+{
+  // first two elements in --order-tile order, returns 1 when the last tile
+  // is done and the following elements have to move
+
+  u64 *poses = chain_kern->poses;
+
+  const u64 stride0 = chain_kern->elems_stride[0];
+  const u64 stride1 = chain_kern->elems_stride[1];
+
+  const u8 *elems0 = chain_kern->elems_buf[0];
+  const u8 *elems1 = chain_kern->elems_buf[1];
+
+  char *pw_buf1 = pw_buf + chain_kern->len[0];
+
+  poses[0]++;
+
+  if (poses[0] < chain_kern->tile_end)
+  {
+    chain_kern->copy[0] ((u8 *) pw_buf, elems0 + poses[0] * stride0);
+
+    return 0;
+  }
+
+  poses[0] = chain_kern->tile_beg;
+
+  poses[1]++;
+
+  if (poses[1] < chain_kern->elems_cnt[1])
+  {
+    // the tile is still cached, the second element is the one coming
+    // from memory
+
+    __builtin_prefetch (elems1 + (poses[1] + 1) * stride1);
+
+    chain_kern->copy[0] ((u8 *) pw_buf,  elems0 + poses[0] * stride0);
+    chain_kern->copy[1] ((u8 *) pw_buf1, elems1 + poses[1] * stride1);
+
+    return 0;
+  }
+
+  poses[1] = 0;
+
+  const u64 tile_cnt = chain_kern->tile_cnt;
+
+  chain_kern->tile_beg = (chain_kern->tile_end == chain_kern->elems_cnt[0]) ? 0 : chain_kern->tile_end;
+  chain_kern->tile_end = MIN (chain_kern->tile_beg + tile_cnt, chain_kern->elems_cnt[0]);
+
+  poses[0] = chain_kern->tile_beg;
+
+  const u8 *elem0 = elems0 + poses[0] * stride0;
+
+  for (u64 off = 0; off < MIN (tile_cnt * stride0, (u64) 0x1000); off += 64)
+  {
+    __builtin_prefetch (elem0 + off);
+  }
+
+  chain_kern->copy[0] ((u8 *) pw_buf,  elem0);
+  chain_kern->copy[1] ((u8 *) pw_buf1, elems1);
+
+  return (chain_kern->tile_beg == 0);
+}
+
+static void chain_set_pwbuf_increment (chain_kern_t *chain_kern, char *pw_buf)
+{
+  const int cnt = chain_kern->cnt;
+
+  u64 *poses = chain_kern->poses;
+
+  int idx = 0;
+
+  if (chain_kern->tile_cnt)
+  {
+    if (chain_set_pwbuf_increment_tiled (chain_kern, pw_buf) == 0) return;
+
+    pw_buf += chain_kern->len[0] + chain_kern->len[1];
+
+    idx = 2;
+  }
+
+  for (; idx < cnt; idx++)
+  {
+    poses[idx]++;
+
+    const u64 elems_idx = poses[idx];
+
+    if (elems_idx < chain_kern->elems_cnt[idx])
+    {
+      chain_kern->copy[idx] ((u8 *) pw_buf, chain_kern->elems_buf[idx] + elems_idx * chain_kern->elems_stride[idx]);
+
+      break;
+    }
+
+    poses[idx] = 0;
+
+    chain_kern->copy[idx] ((u8 *) pw_buf, chain_kern->elems_buf[idx]);
+
+    pw_buf += chain_kern->len[idx];
+  }
+}
+
+static void chain_gen_with_idx (chain_t *chain_buf, const int len1, const int chains_idx)
+{
+  chain_buf->cnt = 0;
+
+  u8 db_key = 1;
+
+  for (int chains_shr = 0; chains_shr < len1; chains_shr++)
+  {
+    if ((chains_idx >> chains_shr) & 1)
+    {
+      chain_buf->buf[chain_buf->cnt] = db_key;
+
+      chain_buf->cnt++;
+
+      db_key = 1;
+    }
+    else
+    {
+      db_key++;
+    }
+  }
+
+  chain_buf->buf[chain_buf->cnt] = db_key;
+
+  chain_buf->cnt++;
+}
+
+static void seek_main_loops (const mpz_t pos, mpz_t *pos_left, mpz_t pw_ks_pos[OUT_LEN_MAX + 1], const mpz_t pw_ks_cnt[OUT_LEN_MAX + 1], const u64 *wordlen_dist, const int pw_min, const int pw_max)
+{
+  // find pw_ks_pos[] at the start of the last main loop not behind pos
+
+  mpz_t main_loops; mpz_init (main_loops);
+  mpz_t tmp;        mpz_init (tmp);
+
+  mpz_set (*pos_left, pos);
+
+  u64 outs_per_main_loop = 0;
+
+  // lengths without any keyspace take no part in a main loop
+
+  for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+  {
+    mpz_init_set_si (pw_ks_pos[pw_len], 0);
+
+    if (mpz_cmp_si (pw_ks_cnt[pw_len], 0) == 0) continue;
+
+    outs_per_main_loop += wordlen_dist[pw_len];
+  }
+
+  while (outs_per_main_loop)
+  {
+    mpz_fdiv_q_ui (main_loops, *pos_left, outs_per_main_loop);
+
+    if (mpz_cmp_si (main_loops, 0) == 0)
+    {
+      break;
+    }
+
+    // increment the main loop "main_loops" times
+
+    for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+    {
+      if (mpz_cmp (pw_ks_pos[pw_len], pw_ks_cnt[pw_len]) < 0)
+      {
+        mpz_mul_ui (tmp, main_loops, wordlen_dist[pw_len]);
+
+        mpz_add (pw_ks_pos[pw_len], pw_ks_pos[pw_len], tmp);
+
+        mpz_sub (*pos_left, *pos_left, tmp);
+
+        if (mpz_cmp (pw_ks_pos[pw_len], pw_ks_cnt[pw_len]) > 0)
+        {
+          mpz_sub (tmp, pw_ks_pos[pw_len], pw_ks_cnt[pw_len]);
+
+          mpz_add (*pos_left, *pos_left, tmp);
+        }
+      }
+    }
+
+    outs_per_main_loop = 0;
+
+    for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+    {
+      if (mpz_cmp (pw_ks_pos[pw_len], pw_ks_cnt[pw_len]) < 0)
+      {
+        outs_per_main_loop += wordlen_dist[pw_len];
+      }
+    }
+  }
+
+  mpz_clear (main_loops);
+  mpz_clear (tmp);
+}
+
+#ifdef LINUX
+static void pw_cnts_at_pos (const mpz_t pos, mpz_t pw_cnts[OUT_LEN_MAX + 1], const mpz_t pw_ks_cnt[OUT_LEN_MAX + 1], const u64 *wordlen_dist, const pw_order_t *pw_orders, const int order_cnt, const int pw_min, const int pw_max)
+{
+  // number of candidates per length among the first pos of the output
+
+  mpz_t pos_left; mpz_init (pos_left);
+  mpz_t tmp;      mpz_init (tmp);
+
+  seek_main_loops (pos, &pos_left, pw_cnts, pw_ks_cnt, wordlen_dist, pw_min, pw_max);
+
+  for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+  {
+    if (mpz_cmp (pw_cnts[pw_len], pw_ks_cnt[pw_len]) > 0)
+    {
+      mpz_set (pw_cnts[pw_len], pw_ks_cnt[pw_len]);
+    }
+  }
+
+  // The rest is less than one main loop of the lengths that still have
+  // keyspace. A length that runs out partway through a main loop hands
+  // its share to the next one, so walk main loops like the generator does
+  // until the rest is used up. Every extra loop is caused by a length
+  // running out, there are at most as many as there are lengths.
+
+  while (mpz_cmp_si (pos_left, 0) > 0)
+  {
+    int progress = 0;
+
+    for (int order_pos = 0; order_pos < order_cnt; order_pos++)
+    {
+      const int pw_len = pw_orders[order_pos].len;
+
+      mpz_sub (tmp, pw_ks_cnt[pw_len], pw_cnts[pw_len]);
+
+      if (mpz_cmp_ui (tmp, wordlen_dist[pw_len]) > 0)
+      {
+        mpz_set_ui (tmp, wordlen_dist[pw_len]);
+      }
+
+      if (mpz_cmp (tmp, pos_left) > 0)
+      {
+        mpz_set (tmp, pos_left);
+      }
+
+      if (mpz_cmp_si (tmp, 0) == 0) continue;
+
+      mpz_add (pw_cnts[pw_len], pw_cnts[pw_len], tmp);
+
+      mpz_sub (pos_left, pos_left, tmp);
+
+      progress = 1;
+    }
+
+    // pos is never past the total keyspace, this is only a safety net
+
+    if (progress == 0) break;
+  }
+
+  mpz_clear (pos_left);
+  mpz_clear (tmp);
+}
+#endif
+
+static void chain_emit_recs (chain_kern_t *chain_kern, char *rec_buf, const int rec_len, const int rec_off, char *dst, u64 cnt)
+{
+  // Candidates come in runs in which only the first element moves, each
+  // run is written as a batch, mostly by the vector kernels of pp_simd.h.
+  // The other elements only change in between two runs. rec_buf holds the
+  // next candidate when done, for the next call.
+
+  const u8 *elems_buf    = chain_kern->elems_buf[0];
+  const u64 elems_stride = chain_kern->elems_stride[0];
+  const int elem_len     = chain_kern->len[0];
+
+  const pp_copy_fn copy = chain_kern->copy[0];
+
+  if (jit_enabled && (chain_kern->jit_done == 0))
+  {
+    chain_kern->jit_fn   = pp_jit_get (elem_len, elems_stride, rec_len, rec_off, jit_term);
+    chain_kern->jit_done = 1;
+  }
+
+  while (cnt)
+  {
+    const u64 elems_idx = chain_kern->poses[0];
+
+    const u64 run_cnt = MIN (cnt, chain_kern->tile_end - elems_idx);
+
+    const u8 *elems = elems_buf + elems_idx * elems_stride;
+
+    u64 done = 0;
+
+    if (chain_kern->jit_fn)
+    {
+      chain_kern->jit_fn ((u8 *) dst, (const u8 *) rec_buf, elems, run_cnt);
+
+      done = run_cnt;
+    }
+    else if (rec_off == 0)
+    {
+      done = pp_simd_run (simd_level, (u8 *) dst, (const u8 *) rec_buf, rec_len, elems, elems_stride, elem_len, run_cnt);
+    }
+
+    for (u64 i = done; i < run_cnt; i++)
+    {
+      char *rec = dst + i * rec_len;
+
+      memcpy (rec, rec_buf, rec_len);
+
+      copy ((u8 *) rec + rec_off, elems + i * elems_stride);
+    }
+
+    dst += run_cnt * rec_len;
+    cnt -= run_cnt;
+
+    chain_kern->poses[0] += run_cnt - 1;
+
+    chain_set_pwbuf_increment (chain_kern, rec_buf + rec_off);
+  }
+}
+
+static int out_push_fit (const out_t *out, const int rec_len)
+{
+  // number of records until the buffer has less than rec_max bytes left
+  // and gets flushed, near the end of an --output-mmap file that is every
+  // record
+
+  const int room = out->size - out->rec_max - out->len;
+
+  return (room < 0) ? 1 : (room / rec_len) + 1;
+}
+
+static void out_push_chain (out_t *out, chain_kern_t *chain_kern, char *rec_buf, const int rec_len, const int rec_off, u64 cnt)
+{
+  // candidates are composed right in the output buffer
+
+  while (cnt)
+  {
+    const u64 fit = out_push_fit (out, rec_len);
+
+    const u64 emit_cnt = MIN (cnt, fit);
+
+    chain_emit_recs (chain_kern, rec_buf, rec_len, rec_off, out->buf + out->len, emit_cnt);
+
+    out->len += (int) emit_cnt * rec_len;
+    out->cnt += emit_cnt;
+
+    cnt -= emit_cnt;
+
+    if (emit_cnt == fit) out_flush (out);
+  }
+}
+
+static void out_push_recs (out_t *out, const char *buf, const int rec_len, u64 cnt)
+{
+  // flushes at the same records as out_push_chain (), so buffer, block and
+  // ring boundaries do not depend on --threads
+
+  while (cnt)
+  {
+    const u64 fit = out_push_fit (out, rec_len);
+
+    const u64 copy_cnt = MIN (cnt, fit);
+
+    const int copy_len = (int) copy_cnt * rec_len;
+
+    memcpy (out->buf + out->len, buf, copy_len);
+
+    out->len += copy_len;
+    out->cnt += copy_cnt;
+
+    buf += copy_len;
+    cnt -= copy_cnt;
+
+    if (copy_cnt == fit) out_flush (out);
+  }
+}
+
+static void gen_job_push (gen_t *gen, gen_job_t *job)
+{
+  if (gen->format == OUT_FORMAT_FRONT)
+  {
+    for (u64 i = 0; i < job->cnt; i++)
+    {
+      out_push_front (job->out, job->buf + i * job->rec_len, job->pw_len);
+    }
+  }
+  else
+  {
+    out_push_recs (job->out, job->buf, job->rec_len, job->cnt);
+  }
+}
+
+static void *gen_thread (void *p)
+{
+  gen_t *gen = (gen_t *) p;
+
+  out_t out;
+
+  if (gen->unordered) out_init_worker (&out, gen->fp);
+
+  pthread_mutex_lock (&gen->mtx);
+
+  while (1)
+  {
+    while ((gen->jobs_take == gen->jobs_fill) && (gen->threads_stop == 0))
+    {
+      pthread_cond_wait (&gen->cond, &gen->mtx);
+    }
+
+    if (gen->jobs_take == gen->jobs_fill) break;
+
+    gen_job_t *job = &gen->jobs[gen->jobs_take % gen->jobs_cnt];
+
+    gen->jobs_take++;
+
+    // with --unordered the slot is free again once the job is copied out
+
+    gen_job_t job_own;
+
+    if (gen->unordered)
+    {
+      job_own = *job;
+
+      job = &job_own;
+
+      pthread_cond_broadcast (&gen->cond);
+    }
+
+    pthread_mutex_unlock (&gen->mtx);
+
+    // the same records the main loop would push one by one
+
+    chain_kern_t chain_kern;
+
+    chain_kern_init (&chain_kern, job->chain_buf, gen->db_entries, job->cur_chain_ks_poses);
+
+    chain_set_pwbuf_init (&chain_kern, job->rec_buf + job->rec_off);
+
+    if (gen->unordered)
+    {
+      // straight into the own buffer, whoever fills one first writes first
+
+      out_push_chain (&out, &chain_kern, job->rec_buf, job->rec_len, job->rec_off, job->cnt);
+
+      pthread_mutex_lock (&gen->mtx);
+
+      continue;
+    }
+
+    chain_emit_recs (&chain_kern, job->rec_buf, job->rec_len, job->rec_off, job->buf, job->cnt);
+
+    pthread_mutex_lock (&gen->mtx);
+
+    job->done = 1;
+
+    pthread_cond_broadcast (&gen->cond);
+  }
+
+  pthread_mutex_unlock (&gen->mtx);
+
+  if (gen->unordered)
+  {
+    out_flush (&out);
+    out_close (&out);
+  }
+
+  return NULL;
+}
+
+static gen_t *gen_init (const db_entry_t *db_entries, const int threads_cnt, const int format, const int unordered, FILE *fp)
+{
+  gen_t *gen = (gen_t *) mem_alloc (sizeof (gen_t));
+
+  gen->db_entries = db_entries;
+  gen->format     = format;
+  gen->unordered  = unordered;
+  gen->fp         = fp;
+
+  gen->jobs_cnt   = threads_cnt * GEN_JOBS_PER_THR;
+  gen->jobs_fill  = 0;
+  gen->jobs_take  = 0;
+  gen->jobs_merge = 0;
+
+  gen->jobs = (gen_job_t *) mem_alloc (gen->jobs_cnt * sizeof (gen_job_t));
+
+  for (int i = 0; i < gen->jobs_cnt; i++)
+  {
+    gen->jobs[i].buf  = (unordered) ? NULL : (char *) mem_alloc (GEN_JOB_SIZE);
+    gen->jobs[i].done = 0;
+  }
+
+  pthread_mutex_init (&gen->mtx, NULL);
+  pthread_cond_init  (&gen->cond, NULL);
+
+  gen->threads_cnt  = threads_cnt;
+  gen->threads_stop = 0;
+
+  gen->threads = (pthread_t *) mem_alloc (threads_cnt * sizeof (pthread_t));
+
+  for (int i = 0; i < threads_cnt; i++)
+  {
+    // workers must not take SIGINT either
+
+    sigset_t set;
+    sigset_t set_old;
+
+    sigemptyset (&set);
+    sigaddset (&set, SIGINT);
+
+    pthread_sigmask (SIG_BLOCK, &set, &set_old);
+
+    if (pthread_create (&gen->threads[i], NULL, gen_thread, gen) != 0)
+    {
+      fprintf (stderr, "pthread_create: %s\n", strerror (errno));
+
+      exit (-1);
+    }
+
+    pthread_sigmask (SIG_SETMASK, &set_old, NULL);
+  }
+
+  return gen;
+}
+
+static void gen_merge (gen_t *gen)
+{
+  // hand the oldest job to its output once it is generated. With
+  // --unordered the workers write their own output, the oldest slot is
+  // free as soon as a worker took it, no matter when that job finishes
+
+  gen_job_t *job = &gen->jobs[gen->jobs_merge % gen->jobs_cnt];
+
+  pthread_mutex_lock (&gen->mtx);
+
+  if (gen->unordered)
+  {
+    while (gen->jobs_take == gen->jobs_merge)
+    {
+      pthread_cond_wait (&gen->cond, &gen->mtx);
+    }
+  }
+  else
+  {
+    while (job->done == 0)
+    {
+      pthread_cond_wait (&gen->cond, &gen->mtx);
+    }
+  }
+
+  pthread_mutex_unlock (&gen->mtx);
+
+  if (gen->unordered == 0) gen_job_push (gen, job);
+
+  job->done = 0;
+
+  gen->jobs_merge++;
+}
+
+static void gen_submit (gen_t *gen, out_t *out, const chain_t *chain_buf, const mpz_t ks_pos, u64 cnt, const char *rec_buf, const int rec_len, const int rec_off, const int pw_len)
+{
+  // split the chain segment into jobs, each starting at its own position
+
+  mpz_t tmp; mpz_init_set (tmp, ks_pos);
+
+  while (cnt)
+  {
+    if (gen->jobs_fill == gen->jobs_merge + gen->jobs_cnt) gen_merge (gen);
+
+    gen_job_t *job = &gen->jobs[gen->jobs_fill % gen->jobs_cnt];
+
+    job->chain_buf = chain_buf;
+    job->out       = out;
+    job->pw_len    = pw_len;
+    job->rec_len   = rec_len;
+    job->rec_off   = rec_off;
+    job->cnt       = MIN (cnt, (u64) (GEN_JOB_SIZE / rec_len));
+
+    memcpy (job->rec_buf, rec_buf, rec_len);
+
+    mpz_t pos; mpz_init_set (pos, tmp);
+
+    set_chain_ks_poses (chain_buf, gen->db_entries, &pos, job->cur_chain_ks_poses);
+
+    mpz_clear (pos);
+
+    mpz_add_ui (tmp, tmp, job->cnt);
+
+    cnt -= job->cnt;
+
+    pthread_mutex_lock (&gen->mtx);
+
+    gen->jobs_fill++;
+
+    pthread_cond_broadcast (&gen->cond);
+
+    pthread_mutex_unlock (&gen->mtx);
+  }
+
+  mpz_clear (tmp);
+}
+
+static void gen_free (gen_t *gen)
+{
+  while (gen->jobs_merge < gen->jobs_fill) gen_merge (gen);
+
+  pthread_mutex_lock (&gen->mtx);
+
+  gen->threads_stop = 1;
+
+  pthread_cond_broadcast (&gen->cond);
+
+  pthread_mutex_unlock (&gen->mtx);
+
+  for (int i = 0; i < gen->threads_cnt; i++)
+  {
+    pthread_join (gen->threads[i], NULL);
+  }
+
+  for (int i = 0; i < gen->jobs_cnt; i++)
+  {
+    free (gen->jobs[i].buf);
+  }
+
+  pthread_mutex_destroy (&gen->mtx);
+  pthread_cond_destroy  (&gen->cond);
+
+  free (gen->threads);
+  free (gen->jobs);
+  free (gen);
+}
+
+static void add_elem (db_entry_t *db_entry, char *input_buf, int input_len)
+{
+  check_realloc_elems (db_entry, input_len);
+
+  u8 *elem_buf = db_entry->elems_buf + db_entry->elems_cnt * db_entry->elems_stride;
+
+  memcpy (elem_buf, input_buf, input_len);
+
+  db_entry->elems_cnt++;
+}
+
+static u64 uniq_mum (const u64 a, const u64 b)
+{
+  const uint128_t r = (uint128_t) a * b;
+
+  return (u64) r ^ (u64) (r >> 64);
+}
+
+static u64 uniq_hash (const u8 *buf, const int len)
+{
+  // wyhash style folding of 64 bit words with a full width multiply, all
+  // elements of a table have the same length so short ones are read as
+  // overlapping words instead of byte by byte
+
+  u64 h = 0xa0761d6478bd642full ^ (u64) len;
+
+  u64 w;
+
+  if (len >= 8)
+  {
+    for (int i = 0; i + 8 < len; i += 8)
+    {
+      memcpy (&w, buf + i, 8);
+
+      h = uniq_mum (w ^ 0xe7037ed1a0b428dbull, h ^ 0x8ebc6af09c88c6e3ull);
+    }
+
+    memcpy (&w, buf + len - 8, 8);
+  }
+  else if (len >= 4)
+  {
+    u32 lo;
+    u32 hi;
+
+    memcpy (&lo, buf, 4);
+    memcpy (&hi, buf + len - 4, 4);
+
+    w = ((u64) hi << 32) | lo;
+  }
+  else
+  {
+    w = ((u64) buf[0] << 16) | ((u64) buf[len >> 1] << 8) | buf[len - 1];
+  }
+
+  h = uniq_mum (w ^ 0xe7037ed1a0b428dbull, h ^ 0x8ebc6af09c88c6e3ull);
+
+  return uniq_mum (h ^ 0x589965cc75374cc3ull, 0x1d8e4e27c47d124full);
+}
+
+static u64 *uniq_slots_alloc (const u64 mask)
+{
+  u64 *slots = (u64 *) calloc (mask + 1, sizeof (u64));
+
+  if (slots == NULL)
+  {
+    fprintf (stderr, "Out of memory trying to allocate %zu bytes\n", (size_t) (mask + 1) * sizeof (u64));
+
+    exit (-1);
+  }
+
+  return slots;
+}
+
+static uniq_t *uniq_alloc (void)
+{
+  uniq_t *uniq = (uniq_t *) mem_alloc (sizeof (uniq_t));
+
+  uniq->mask  = (1ull << UNIQ_LOG_SIZE_MIN) - 1;
+  uniq->slots = uniq_slots_alloc (uniq->mask);
+  uniq->cnt   = 0;
+
+  return uniq;
+}
+
+static void uniq_free (uniq_t *uniq)
+{
+  free (uniq->slots);
+  free (uniq);
+}
+
+static void uniq_grow (uniq_t *uniq, const db_entry_t *db_entry, const int input_len)
+{
+  // the elements are the keys, rehash them in place of keeping full hashes
+
+  const u64 mask = (uniq->mask << 1) | 1;
+
+  u64 *slots = uniq_slots_alloc (mask);
+
+  for (u64 elems_idx = 0; elems_idx < uniq->cnt; elems_idx++)
+  {
+    const u64 h = uniq_hash (db_entry->elems_buf + elems_idx * db_entry->elems_stride, input_len);
+
+    u64 pos = h & mask;
+
+    while (slots[pos]) pos = (pos + 1) & mask;
+
+    slots[pos] = (h & 0xffffffff00000000ull) | (elems_idx + 1);
+  }
+
+  free (uniq->slots);
+
+  uniq->slots = slots;
+  uniq->mask  = mask;
+}
+
+static void add_uniq (db_entry_t *db_entry, char *input_buf, int input_len)
+{
+  uniq_t *uniq = db_entry->uniq;
+
+  const u64 h = uniq_hash ((const u8 *) input_buf, input_len);
+
+  const u64 fp = h & 0xffffffff00000000ull;
+
+  u64 pos = h & uniq->mask;
+
+  for (u64 slot = uniq->slots[pos]; slot; slot = uniq->slots[pos])
+  {
+    // uniq entries and elements are added together, so the slot holds the element index
+
+    if ((slot & 0xffffffff00000000ull) == fp)
+    {
+      const u64 elems_idx = (slot & 0xffffffff) - 1;
+
+      if (memcmp (input_buf, db_entry->elems_buf + elems_idx * db_entry->elems_stride, input_len) == 0) return;
+    }
+
+    pos = (pos + 1) & uniq->mask;
+  }
+
+  uniq->slots[pos] = fp | (uniq->cnt + 1);
+
+  uniq->cnt++;
+
+  add_elem (db_entry, input_buf, input_len);
+
+  // keep the load below 3/4, the probe runs stay short at any list size
+
+  if ((uniq->cnt * 4) > (uniq->mask * 3)) uniq_grow (uniq, db_entry, input_len);
+}
+
+static void in_shard_add (in_shard_t *shard, const char *input_buf, const int input_len, const u32 ord)
+{
+  if (shard->cnt == shard->alloc)
+  {
+    shard->alloc += ALLOC_NEW_ELEMS;
+
+    shard->buf  = (u8 *)  realloc (shard->buf,  shard->alloc * input_len);
+    shard->ords = (u32 *) realloc (shard->ords, shard->alloc * sizeof (u32));
+
+    if ((shard->buf == NULL) || (shard->ords == NULL))
+    {
+      fprintf (stderr, "Out of memory trying to allocate %zu bytes\n", (size_t) shard->alloc * input_len);
+
+      exit (-1);
+    }
+  }
+
+  memcpy (shard->buf + shard->cnt * input_len, input_buf, input_len);
+
+  shard->ords[shard->cnt] = ord;
+
+  shard->cnt++;
+}
+
+static void in_add (in_t *in, char *input_buf, const int input_len)
+{
+  if (in->shards)
+  {
+    in_shard_add (&in->shards[input_len], input_buf, input_len, in->wl_cnt);
+
+    return;
+  }
+
+  db_entry_t *db_entry = &in->db_entries[input_len];
+
+  if (!in->dupe_check)
+  {
+    add_elem (db_entry, input_buf, input_len);
+  }
+  else
+  {
+    add_uniq (db_entry, input_buf, input_len);
+  }
+}
+
+static void in_word (in_t *in, const char *input_buf, const int input_len)
+{
+  if (input_len < IN_LEN_MIN) return;
+  if (input_len > IN_LEN_MAX) return;
+
+  if (input_len > in->pw_max) return;
+
+  // the input may be a read-only mapping of the wordlist
+
+  char word[IN_LEN_MAX];
+
+  memcpy (word, input_buf, input_len);
+
+  in_add (in, word, input_len);
+
+  if (in->case_permute)
+  {
+    const char old_c = word[0];
+
+    const char new_cu = toupper (old_c);
+    const char new_cl = tolower (old_c);
+
+    if (old_c != new_cu)
+    {
+      word[0] = new_cu;
+
+      in_add (in, word, input_len);
+    }
+
+    if (old_c != new_cl)
+    {
+      word[0] = new_cl;
+
+      in_add (in, word, input_len);
+    }
+  }
+
+  in->wl_cnt++;
+}
+
+static u64 in_parse (in_t *in, const char *buf, const u64 len, const int eof)
+{
+  // Splits buf the way fgets () into a BUFSIZ buffer did: a line is cut
+  // after its newline or after BUFSIZ - 1 bytes, whatever comes first, and
+  // the pieces of a longer line are words of their own. A NUL byte ends the
+  // word early like strlen () did, those rare lines go through
+  // in_superchop () as before. Returns the bytes consumed, the rest of an
+  // unfinished line is left for the next call unless eof is set.
+
+  const char *ptr = buf;
+  const char *end = buf + len;
+
+  while (ptr < end)
+  {
+    const u64 window = MIN ((u64) (end - ptr), (u64) (BUFSIZ - 1));
+
+    u64 pos = pp_simd_find_eol (simd_level, (const u8 *) ptr, window);
+
+    int has_nul = 0;
+
+    if ((pos < window) && (ptr[pos] == 0))
+    {
+      has_nul = 1;
+
+      const char *nl = (const char *) memchr (ptr + pos, '\n', window - pos);
+
+      pos = (nl) ? (u64) (nl - ptr) : window;
+    }
+
+    u64 chunk_len;
+
+    if (pos < window)
+    {
+      chunk_len = pos + 1;
+    }
+    else if ((window == BUFSIZ - 1) || eof)
+    {
+      chunk_len = window;
+    }
+    else
+    {
+      break;
+    }
+
+    if (has_nul)
+    {
+      char tmp[BUFSIZ];
+
+      memcpy (tmp, ptr, chunk_len);
+
+      tmp[chunk_len] = 0;
+
+      in_word (in, tmp, in_superchop (tmp));
+    }
+    else
+    {
+      int input_len = chunk_len;
+
+      while (input_len && ((ptr[input_len - 1] == '\n') || (ptr[input_len - 1] == '\r'))) input_len--;
+
+      in_word (in, ptr, input_len);
+    }
+
+    ptr += chunk_len;
+
+    if ((in->wl_max > 0) && (in->wl_cnt == in->wl_max)) break;
+  }
+
+  return ptr - buf;
+}
+
+static void *in_parse_thread (void *p)
+{
+  in_job_t *job = (in_job_t *) p;
+
+  in_parse (&job->in, job->buf, job->len, 1);
+
+  return NULL;
+}
+
+static void *in_merge_thread (void *p)
+{
+  // Each length is filled by one thread from the shards in input order,
+  // so every db_entry sees its words in the order a single thread would
+
+  in_merge_t *merge = (in_merge_t *) p;
+
+  in_t *in = merge->in;
+
+  const u64 limit = (in->wl_max > 0) ? (u64) in->wl_max : 0;
+
+  while (1)
+  {
+    pthread_mutex_lock (&merge->mtx);
+
+    const int input_len = merge->next_len++;
+
+    pthread_mutex_unlock (&merge->mtx);
+
+    if (input_len > IN_LEN_MAX) break;
+
+    db_entry_t *db_entry = &in->db_entries[input_len];
+
+    for (int jobs_idx = 0; jobs_idx < merge->jobs_cnt; jobs_idx++)
+    {
+      const in_job_t *job = &merge->jobs[jobs_idx];
+
+      const in_shard_t *shard = &job->shards[input_len];
+
+      for (u64 i = 0; i < shard->cnt; i++)
+      {
+        // words past --wl-max were parsed ahead but are not taken
+
+        if (limit && ((job->base + shard->ords[i]) >= limit)) break;
+
+        char *input_buf = (char *) shard->buf + i * input_len;
+
+        if (!in->dupe_check)
+        {
+          add_elem (db_entry, input_buf, input_len);
+        }
+        else
+        {
+          add_uniq (db_entry, input_buf, input_len);
+        }
+      }
+    }
+  }
+
+  return NULL;
+}
+
+static u64 in_parse_mt (in_t *in, in_job_t *jobs, const char *buf, const u64 len, const int eof)
+{
+  // Same contract as in_parse (). Each block of the input is cut at line
+  // ends into one piece per thread, the pieces are parsed in parallel into
+  // per length shards, then the lengths are deduped in parallel. Returns
+  // IN_PARSE_FAIL if a thread could not be started.
+
+  const int threads = in->threads;
+
+  const char *ptr = buf;
+  const char *end = buf + len;
+
+  while (ptr < end)
+  {
+    const u64 left = end - ptr;
+
+    const int last = eof && (left <= IN_BLOCK_SIZE);
+
+    u64 block_len = MIN (left, (u64) IN_BLOCK_SIZE);
+
+    if (last == 0)
+    {
+      // unfinished lines wait for the next block
+
+      while (block_len && (ptr[block_len - 1] != '\n')) block_len--;
+
+      if (block_len == 0)
+      {
+        // no line end in a whole block, in_parse () cuts it into pieces
+
+        const u64 done = in_parse (in, ptr, MIN (left, (u64) IN_BLOCK_SIZE), 0);
+
+        if (done == 0) break;
+
+        ptr += done;
+
+        if ((in->wl_max > 0) && (in->wl_cnt == in->wl_max)) break;
+
+        continue;
+      }
+    }
+
+    // an fgets () piece starts after every newline, so the cuts between
+    // the threads go right after one
+
+    const char *piece_beg = ptr;
+
+    for (int jobs_idx = 0; jobs_idx < threads; jobs_idx++)
+    {
+      const char *piece_end = ptr + block_len;
+
+      if (jobs_idx < threads - 1)
+      {
+        const char *cut = ptr + block_len / threads * (jobs_idx + 1);
+
+        if (cut < piece_beg) cut = piece_beg;
+
+        const char *nl = (const char *) memchr (cut, '\n', piece_end - cut);
+
+        if (nl) piece_end = nl + 1;
+      }
+
+      in_job_t *job = &jobs[jobs_idx];
+
+      job->in        = *in;
+      job->in.shards = job->shards;
+      job->in.wl_max = 0;
+      job->in.wl_cnt = 0;
+
+      job->buf = piece_beg;
+      job->len = piece_end - piece_beg;
+
+      for (int input_len = 0; input_len <= IN_LEN_MAX; input_len++) job->shards[input_len].cnt = 0;
+
+      if (pthread_create (&job->thread, NULL, in_parse_thread, job) != 0)
+      {
+        fprintf (stderr, "pthread_create: %s\n", strerror (errno));
+
+        for (int i = 0; i < jobs_idx; i++) pthread_join (jobs[i].thread, NULL);
+
+        return IN_PARSE_FAIL;
+      }
+
+      piece_beg = piece_end;
+    }
+
+    u64 base = in->wl_cnt;
+
+    for (int jobs_idx = 0; jobs_idx < threads; jobs_idx++)
+    {
+      in_job_t *job = &jobs[jobs_idx];
+
+      pthread_join (job->thread, NULL);
+
+      job->base = base;
+
+      base += job->in.wl_cnt;
+    }
+
+    in_merge_t merge;
+
+    merge.in       = in;
+    merge.jobs     = jobs;
+    merge.jobs_cnt = threads;
+    merge.next_len = IN_LEN_MIN;
+
+    pthread_mutex_init (&merge.mtx, NULL);
+
+    int threads_cnt = 0;
+
+    for (; threads_cnt < threads; threads_cnt++)
+    {
+      if (pthread_create (&merge.threads[threads_cnt], NULL, in_merge_thread, &merge) != 0)
+      {
+        fprintf (stderr, "pthread_create: %s\n", strerror (errno));
+
+        break;
+      }
+    }
+
+    for (int thread_idx = 0; thread_idx < threads_cnt; thread_idx++)
+    {
+      pthread_join (merge.threads[thread_idx], NULL);
+    }
+
+    pthread_mutex_destroy (&merge.mtx);
+
+    if (threads_cnt < threads) return IN_PARSE_FAIL;
+
+    in->wl_cnt = ((in->wl_max > 0) && (base > (u64) in->wl_max)) ? in->wl_max : (int) base;
+
+    ptr += block_len;
+
+    if ((in->wl_max > 0) && (in->wl_cnt == in->wl_max)) break;
+  }
+
+  return ptr - buf;
+}
+
+static u64 in_parse_any (in_t *in, in_job_t *jobs, const char *buf, const u64 len, const int eof)
+{
+  if (jobs) return in_parse_mt (in, jobs, buf, len, eof);
+
+  return in_parse (in, buf, len, eof);
+}
+
+static int in_load_blocks (in_t *in, in_job_t *jobs, FILE *fp, const char *name)
+{
+  #ifdef LINUX
+
+  // regular files are mapped and parsed in one go
+
+  const int fd = fileno (fp);
+
+  struct stat st;
+
+  if ((fstat (fd, &st) == 0) && S_ISREG (st.st_mode) && (st.st_size > 0) && (lseek (fd, 0, SEEK_CUR) == 0))
+  {
+    void *map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (map != MAP_FAILED)
+    {
+      madvise (map, st.st_size, MADV_SEQUENTIAL);
+
+      if (in->sum) pp_db_sum_update (in->sum, (const u8 *) map, st.st_size);
+
+      const u64 done = in_parse_any (in, jobs, (const char *) map, st.st_size, 1);
+
+      munmap (map, st.st_size);
+
+      return (done == IN_PARSE_FAIL) ? -1 : 0;
+    }
+  }
+
+  #endif
+
+  // pipes and everything else are read in large blocks, an unfinished
+  // line is at most BUFSIZ - 1 bytes and moves to the front
+
+  char *block = (char *) malloc (IN_BLOCK_SIZE);
+
+  if (block == NULL)
+  {
+    fprintf (stderr, "Out of memory trying to allocate %d bytes\n", IN_BLOCK_SIZE);
+
+    return (-1);
+  }
+
+  u64 block_len = 0;
+
+  while (1)
+  {
+    const size_t want = IN_BLOCK_SIZE - block_len;
+
+    const size_t nread = fread (block + block_len, 1, want, fp);
+
+    if (in->sum) pp_db_sum_update (in->sum, (const u8 *) block + block_len, nread);
+
+    block_len += nread;
+
+    const int eof = (nread < want);
+
+    const int full = (in->wl_max > 0) && (in->wl_cnt == in->wl_max);
+
+    // the sum covers the whole wordlist, keep reading past --wl-max for it
+
+    const u64 done = (full) ? block_len : in_parse_any (in, jobs, block, block_len, eof);
+
+    if (done == IN_PARSE_FAIL)
+    {
+      free (block);
+
+      return (-1);
+    }
+
+    memmove (block, block + done, block_len - done);
+
+    block_len -= done;
+
+    if ((in->wl_max > 0) && (in->wl_cnt == in->wl_max) && (in->sum == NULL)) break;
+
+    if (eof) break;
+  }
+
+  free (block);
+
+  if (ferror (fp))
+  {
+    fprintf (stderr, "%s: %s\n", name, strerror (errno));
+
+    return (-1);
+  }
+
+  return 0;
+}
+
+static int in_load (in_t *in, FILE *fp, const char *name)
+{
+  in_job_t *jobs = NULL;
+
+  if (in->threads > 1)
+  {
+    jobs = (in_job_t *) calloc (in->threads, sizeof (in_job_t));
+
+    if (jobs == NULL)
+    {
+      fprintf (stderr, "Out of memory trying to allocate %zu bytes\n", (size_t) in->threads * sizeof (in_job_t));
+
+      return (-1);
+    }
+  }
+
+  const int rc = in_load_blocks (in, jobs, fp, name);
+
+  if (jobs)
+  {
+    for (int jobs_idx = 0; jobs_idx < in->threads; jobs_idx++)
+    {
+      for (int input_len = 0; input_len <= IN_LEN_MAX; input_len++)
+      {
+        free (jobs[jobs_idx].shards[input_len].buf);
+        free (jobs[jobs_idx].shards[input_len].ords);
+      }
+    }
+
+    free (jobs);
+  }
+
+  return rc;
+}
+
+enum
+{
+  DUPE_SORT_PASS_TOP     = 0,
+  DUPE_SORT_PASS_BUCKETS = 1,
+  DUPE_SORT_PASS_UNIQUE  = 2,
+  DUPE_SORT_PASS_COMPACT = 3,
+
+};
+
+static void dupe_sort_partition (u8 *buf, const u64 cnt, const int rec_len, const int key_pos, u64 *bounds)
+{
+  // one in place MSD radix pass on the byte at key_pos, the records are
+  // cycled into their bucket one swap at a time
+
+  u64 counts[256] = { 0 };
+
+  for (u64 i = 0; i < cnt; i++) counts[buf[i * rec_len + key_pos]]++;
+
+  bounds[0] = 0;
+
+  for (int b = 0; b < 256; b++) bounds[b + 1] = bounds[b] + counts[b];
+
+  u64 heads[256];
+
+  memcpy (heads, bounds, sizeof (heads));
+
+  u8 cur[IN_LEN_MAX + 8];
+  u8 tmp[IN_LEN_MAX + 8];
+
+  for (int b = 0; b < 256; b++)
+  {
+    while (heads[b] < bounds[b + 1])
+    {
+      u8 *rec = buf + heads[b] * rec_len;
+
+      if (rec[key_pos] == b)
+      {
+        heads[b]++;
+
+        continue;
+      }
+
+      memcpy (cur, rec, rec_len);
+
+      while (cur[key_pos] != b)
+      {
+        u8 *dst = buf + heads[cur[key_pos]]++ * rec_len;
+
+        memcpy (tmp, dst, rec_len);
+        memcpy (dst, cur, rec_len);
+        memcpy (cur, tmp, rec_len);
+      }
+
+      memcpy (rec, cur, rec_len);
+
+      heads[b]++;
+    }
+  }
+}
+
+static void dupe_sort_range (u8 *buf, const u64 cnt, const int rec_len, const int key_off, const int key_len, const int depth)
+{
+  if (depth == key_len) return;
+
+  if (cnt < DUPE_SORT_SMALL)
+  {
+    const int cmp_off = key_off + depth;
+    const int cmp_len = key_len - depth;
+
+    u8 cur[IN_LEN_MAX + 8];
+
+    for (u64 i = 1; i < cnt; i++)
+    {
+      memcpy (cur, buf + i * rec_len, rec_len);
+
+      u64 j = i;
+
+      while ((j > 0) && (memcmp (buf + (j - 1) * rec_len + cmp_off, cur + cmp_off, cmp_len) > 0))
+      {
+        memcpy (buf + j * rec_len, buf + (j - 1) * rec_len, rec_len);
+
+        j--;
+      }
+
+      if (j != i) memcpy (buf + j * rec_len, cur, rec_len);
+    }
+
+    return;
+  }
+
+  u64 bounds[256 + 1];
+
+  dupe_sort_partition (buf, cnt, rec_len, key_off + depth, bounds);
+
+  for (int b = 0; b < 256; b++)
+  {
+    const u64 bucket_cnt = bounds[b + 1] - bounds[b];
+
+    if (bucket_cnt < 2) continue;
+
+    dupe_sort_range (buf + bounds[b] * rec_len, bucket_cnt, rec_len, key_off, key_len, depth + 1);
+  }
+}
+
+static void dupe_sort_widen (dupe_sort_job_t *job)
+{
+  // append the position in the wordlist to each element, big endian so
+  // the radix passes sort it like any other key
+
+  db_entry_t *db_entry = job->db_entry;
+
+  const u64 cnt = db_entry->elems_cnt;
+
+  const int stride = (int) db_entry->elems_stride;
+
+  u8 *buf = (u8 *) realloc (db_entry->elems_buf, cnt * job->rec_len + PP_SIMD_PAD);
+
+  if (buf == NULL)
+  {
+    fprintf (stderr, "Out of memory trying to allocate %zu bytes\n", (size_t) cnt * job->rec_len);
+
+    exit (-1);
+  }
+
+  for (u64 i = cnt; i-- > 0; )
+  {
+    u8 *rec = buf + i * job->rec_len;
+
+    memmove (rec, buf + i * stride, stride);
+
+    for (int k = 0; k < job->ord_len; k++) rec[stride + k] = (u8) (i >> (8 * (job->ord_len - 1 - k)));
+  }
+
+  db_entry->elems_buf   = buf;
+  db_entry->elems_alloc = cnt;
+}
+
+static void dupe_sort_unique (dupe_sort_job_t *job)
+{
+  // equal elements are neighbours now, the first one of each run stays and
+  // takes the lowest wordlist position of the run
+
+  db_entry_t *db_entry = job->db_entry;
+
+  u8 *buf = db_entry->elems_buf;
+
+  const int rec_len = job->rec_len;
+  const int ord_off = rec_len - job->ord_len;
+
+  u64 out = 0;
+
+  for (u64 i = 0; i < db_entry->elems_cnt; i++)
+  {
+    u8 *rec = buf + i * rec_len;
+
+    if (out)
+    {
+      u8 *last = buf + (out - 1) * rec_len;
+
+      if (memcmp (last, rec, job->elem_len) == 0)
+      {
+        if (memcmp (last + ord_off, rec + ord_off, job->ord_len) > 0) memcpy (last + ord_off, rec + ord_off, job->ord_len);
+
+        continue;
+      }
+    }
+
+    if (out != i) memcpy (buf + out * rec_len, rec, rec_len);
+
+    out++;
+  }
+
+  db_entry->elems_cnt = out;
+}
+
+static void dupe_sort_compact (dupe_sort_job_t *job)
+{
+  db_entry_t *db_entry = job->db_entry;
+
+  const u64 cnt = db_entry->elems_cnt;
+
+  const int stride = (int) db_entry->elems_stride;
+
+  u8 *buf = db_entry->elems_buf;
+
+  if (job->rec_len != stride)
+  {
+    for (u64 i = 0; i < cnt; i++) memmove (buf + i * stride, buf + i * job->rec_len, stride);
+  }
+
+  // give the unused tail back, elements and slack only
+
+  u8 *buf_new = (u8 *) realloc (buf, cnt * stride + PP_SIMD_PAD);
+
+  if (buf_new) buf = buf_new;
+
+  memset (buf + cnt * stride, 0, PP_SIMD_PAD);
+
+  db_entry->elems_buf   = buf;
+  db_entry->elems_alloc = cnt;
+}
+
+static void *dupe_sort_thread (void *p)
+{
+  dupe_sort_t *sort = (dupe_sort_t *) p;
+
+  // the bucket pass hands out each of the 256 buckets of each length on
+  // its own, a single dominating length is still sorted in parallel
+
+  const int items = (sort->pass == DUPE_SORT_PASS_BUCKETS) ? sort->jobs_cnt * 256 : sort->jobs_cnt;
+
+  while (1)
+  {
+    pthread_mutex_lock (&sort->mtx);
+
+    const int item = sort->next++;
+
+    pthread_mutex_unlock (&sort->mtx);
+
+    if (item >= items) break;
+
+    if (sort->pass == DUPE_SORT_PASS_BUCKETS)
+    {
+      dupe_sort_job_t *job = &sort->jobs[item / 256];
+
+      const int b = item % 256;
+
+      const u64 bucket_cnt = job->bounds[b + 1] - job->bounds[b];
+
+      if (bucket_cnt < 2) continue;
+
+      dupe_sort_range (job->db_entry->elems_buf + job->bounds[b] * job->rec_len, bucket_cnt, job->rec_len, job->key_off, job->key_len, 1);
+
+      continue;
+    }
+
+    dupe_sort_job_t *job = &sort->jobs[item];
+
+    switch (sort->pass)
+    {
+      case DUPE_SORT_PASS_TOP:
+
+        if (job->ord_len && (job->key_off == 0)) dupe_sort_widen (job);
+
+        dupe_sort_partition (job->db_entry->elems_buf, job->db_entry->elems_cnt, job->rec_len, job->key_off, job->bounds);
+
+        break;
+
+      case DUPE_SORT_PASS_UNIQUE:
+
+        dupe_sort_unique (job);
+
+        break;
+
+      case DUPE_SORT_PASS_COMPACT:
+
+        dupe_sort_compact (job);
+
+        break;
+    }
+  }
+
+  return NULL;
+}
+
+static void dupe_sort_run (dupe_sort_t *sort, const int pass, const int threads)
+{
+  sort->pass = pass;
+  sort->next = 0;
+
+  for (int thread_idx = 0; thread_idx < threads; thread_idx++)
+  {
+    if (pthread_create (&sort->threads[thread_idx], NULL, dupe_sort_thread, sort) != 0)
+    {
+      fprintf (stderr, "pthread_create: %s\n", strerror (errno));
+
+      exit (-1);
+    }
+  }
+
+  for (int thread_idx = 0; thread_idx < threads; thread_idx++)
+  {
+    pthread_join (sort->threads[thread_idx], NULL);
+  }
+}
+
+static void dupe_sort (db_entry_t *db_entries, const int in_max, const int keep_order, const int threads)
+{
+  // Dupes check after loading without an index next to the elements: the
+  // elements of each length are radix sorted in place, runs of equal ones
+  // are cut down to one. With keep_order each element carries its wordlist
+  // position through the sort and a second sort on it restores the order.
+
+  dupe_sort_job_t *jobs = (dupe_sort_job_t *) calloc (in_max + 1, sizeof (dupe_sort_job_t));
+
+  if (jobs == NULL)
+  {
+    fprintf (stderr, "Out of memory trying to allocate %zu bytes\n", (size_t) (in_max + 1) * sizeof (dupe_sort_job_t));
+
+    exit (-1);
+  }
+
+  int jobs_cnt = 0;
+
+  for (int input_len = IN_LEN_MIN; input_len <= in_max; input_len++)
+  {
+    db_entry_t *db_entry = &db_entries[input_len];
+
+    if (db_entry->elems_cnt == 0) continue;
+
+    dupe_sort_job_t *job = &jobs[jobs_cnt++];
+
+    job->db_entry = db_entry;
+    job->elem_len = input_len;
+    job->ord_len  = (keep_order == 0) ? 0 : (db_entry->elems_cnt > 0xffffffff) ? 8 : 4;
+    job->rec_len  = (int) db_entry->elems_stride + job->ord_len;
+    job->key_off  = 0;
+    job->key_len  = input_len;
+  }
+
+  dupe_sort_t sort;
+
+  sort.jobs     = jobs;
+  sort.jobs_cnt = jobs_cnt;
+
+  pthread_mutex_init (&sort.mtx, NULL);
+
+  dupe_sort_run (&sort, DUPE_SORT_PASS_TOP,     threads);
+  dupe_sort_run (&sort, DUPE_SORT_PASS_BUCKETS, threads);
+  dupe_sort_run (&sort, DUPE_SORT_PASS_UNIQUE,  threads);
+
+  if (keep_order)
+  {
+    for (int jobs_idx = 0; jobs_idx < jobs_cnt; jobs_idx++)
+    {
+      dupe_sort_job_t *job = &jobs[jobs_idx];
+
+      job->key_off = job->rec_len - job->ord_len;
+      job->key_len = job->ord_len;
+    }
+
+    dupe_sort_run (&sort, DUPE_SORT_PASS_TOP,     threads);
+    dupe_sort_run (&sort, DUPE_SORT_PASS_BUCKETS, threads);
+  }
+
+  dupe_sort_run (&sort, DUPE_SORT_PASS_COMPACT, threads);
+
+  pthread_mutex_destroy (&sort.mtx);
+
+  free (jobs);
+}
+
+#if IN_LEN_MAX > PP_DB_LEN_MAX
+#error IN_LEN_MAX does not fit into the --build-db format
+#endif
+
+static int db_build (const db_entry_t *db_entries, const in_t *in, const u32 flags, const char *name)
+{
+  pp_db_hdr_t hdr;
+
+  memset (&hdr, 0, sizeof (hdr));
+
+  hdr.magic    = PP_DB_MAGIC;
+  hdr.version  = PP_DB_VERSION;
+  hdr.len_max  = PP_DB_LEN_MAX;
+  hdr.flags    = flags;
+  hdr.wl_max   = in->wl_max;
+  hdr.wl_cnt   = in->wl_cnt;
+  hdr.src_size = in->sum->len;
+  hdr.src_sum  = pp_db_sum_final (in->sum);
+
+  u64 off = PP_DB_PAGE;
+
+  for (int input_len = IN_LEN_MIN; input_len <= IN_LEN_MAX; input_len++)
+  {
+    const db_entry_t *db_entry = &db_entries[input_len];
+
+    if (db_entry->elems_cnt == 0) continue;
+
+    pp_db_entry_t *entry = &hdr.entries[input_len];
+
+    entry->off    = pp_db_align (off);
+    entry->cnt    = db_entry->elems_cnt;
+    entry->stride = db_entry->elems_stride;
+
+    off = entry->off + entry->cnt * entry->stride + PP_DB_PAD;
+  }
+
+  hdr.size = pp_db_align (off);
+
+  FILE *fp = fopen (name, "wb");
+
+  if (fp == NULL)
+  {
+    fprintf (stderr, "%s: %s\n", name, strerror (errno));
+
+    return (-1);
+  }
+
+  static const u8 zeros[PP_DB_PAGE];
+
+  int fails = 0;
+
+  fails += (fwrite (&hdr, sizeof (hdr), 1, fp) != 1);
+
+  u64 pos = sizeof (hdr);
+
+  for (int input_len = IN_LEN_MIN; input_len <= IN_LEN_MAX + 1; input_len++)
+  {
+    // gaps up to the next array, or the end of the file, are zero filled
+
+    const u64 next = (input_len <= IN_LEN_MAX) ? hdr.entries[input_len].off : hdr.size;
+
+    if (next == 0) continue;
+
+    for (; pos < next; pos += MIN (next - pos, PP_DB_PAGE))
+    {
+      fails += (fwrite (zeros, MIN (next - pos, PP_DB_PAGE), 1, fp) != 1);
+    }
+
+    if (input_len > IN_LEN_MAX) break;
+
+    const pp_db_entry_t *entry = &hdr.entries[input_len];
+
+    fails += (fwrite (db_entries[input_len].elems_buf, entry->cnt * entry->stride, 1, fp) != 1);
+
+    pos += entry->cnt * entry->stride;
+  }
+
+  if ((fclose (fp) != 0) || fails)
+  {
+    fprintf (stderr, "%s: %s\n", name, strerror (errno));
+
+    return (-1);
+  }
+
+  return 0;
+}
+
+static int db_check_src (const pp_db_hdr_t *hdr, const char *name, const char *wordlist)
+{
+  FILE *fp = fopen (wordlist, "rb");
+
+  if (fp == NULL)
+  {
+    fprintf (stderr, "%s: %s\n", wordlist, strerror (errno));
+
+    return (-1);
+  }
+
+  u8 *buf = (u8 *) mem_alloc (IN_BLOCK_SIZE);
+
+  pp_db_sum_t sum;
+
+  pp_db_sum_init (&sum);
+
+  size_t n;
+
+  while ((n = fread (buf, 1, IN_BLOCK_SIZE, fp)) > 0) pp_db_sum_update (&sum, buf, n);
+
+  const int err = ferror (fp);
+
+  free (buf);
+
+  fclose (fp);
+
+  if (err)
+  {
+    fprintf (stderr, "%s: %s\n", wordlist, strerror (EIO));
+
+    return (-1);
+  }
+
+  if ((sum.len != hdr->src_size) || (pp_db_sum_final (&sum) != hdr->src_sum))
+  {
+    fprintf (stderr, "%s: Database was not built from %s, rebuild it with --build-db\n", name, wordlist);
+
+    return (-1);
+  }
+
+  return 0;
+}
+
+static int db_load (db_entry_t *db_entries, const int in_max, const char *name, const char *wordlist, const int flags, const int wl_max, u8 **db_map, u64 *db_size)
+{
+  // The element arrays are used in place, nothing is copied. The mapping
+  // is shared, concurrent processes on the same file use the same pages.
+
+  FILE *fp = fopen (name, "rb");
+
+  if (fp == NULL)
+  {
+    fprintf (stderr, "%s: %s\n", name, strerror (errno));
+
+    return (-1);
+  }
+
+  fseeko (fp, 0, SEEK_END);
+
+  const u64 size = (u64) ftello (fp);
+
+  if (size < sizeof (pp_db_hdr_t))
+  {
+    fprintf (stderr, "%s: Not a pp database\n", name);
+
+    fclose (fp);
+
+    return (-1);
+  }
+
+  #ifdef LINUX
+
+  u8 *map = (u8 *) mmap (NULL, size, PROT_READ, MAP_SHARED, fileno (fp), 0);
+
+  if (map == MAP_FAILED)
+  {
+    fprintf (stderr, "%s: %s\n", name, strerror (errno));
+
+    fclose (fp);
+
+    return (-1);
+  }
+
+  #else
+
+  u8 *map = (u8 *) malloc (size);
+
+  if (map == NULL)
+  {
+    fprintf (stderr, "Out of memory trying to allocate %zu bytes\n", (size_t) size);
+
+    fclose (fp);
+
+    return (-1);
+  }
+
+  fseeko (fp, 0, SEEK_SET);
+
+  if (fread (map, size, 1, fp) != 1)
+  {
+    fprintf (stderr, "%s: %s\n", name, strerror (errno));
+
+    fclose (fp);
+
+    return (-1);
+  }
+
+  #endif
+
+  fclose (fp);
+
+  *db_map  = map;
+  *db_size = size;
+
+  const pp_db_hdr_t *hdr = (const pp_db_hdr_t *) map;
+
+  if (hdr->magic != PP_DB_MAGIC)
+  {
+    fprintf (stderr, "%s: Not a pp database\n", name);
+
+    return (-1);
+  }
+
+  if ((hdr->version != PP_DB_VERSION) || (hdr->len_max != PP_DB_LEN_MAX))
+  {
+    fprintf (stderr, "%s: Database version %u is not supported, rebuild it with --build-db\n", name, hdr->version);
+
+    return (-1);
+  }
+
+  if (hdr->size != size)
+  {
+    fprintf (stderr, "%s: Database is truncated\n", name);
+
+    return (-1);
+  }
+
+  // --wl-max counts the words of the lengths that are loaded, the build
+  // loads all of them. A database cut at its limit only matches a direct
+  // run with the same limit that loads every length, one that is not cut
+  // matches every run whose limit is not reached before its end.
+
+  const int cut = (hdr->wl_max > 0) && (hdr->wl_cnt >= hdr->wl_max);
+
+  if (cut && ((u64) wl_max != hdr->wl_max))
+  {
+    fprintf (stderr, "%s: Database holds the first %llu words of its wordlist, use it with --wl-max=%llu or rebuild it with --wl-max=%d\n", name, (unsigned long long) hdr->wl_max, (unsigned long long) hdr->wl_max, wl_max);
+
+    return (-1);
+  }
+
+  if (cut && (in_max < PP_DB_LEN_MAX))
+  {
+    fprintf (stderr, "%s: Database holds the first %llu words of any length, a direct run with --pw-max=%d reads further, rebuild it with a larger --wl-max or 0\n", name, (unsigned long long) hdr->wl_max, in_max);
+
+    return (-1);
+  }
+
+  if ((cut == 0) && (wl_max > 0) && ((u64) wl_max <= hdr->wl_cnt))
+  {
+    fprintf (stderr, "%s: Database holds all %llu words of its wordlist, --wl-max=%d may load less of them, rebuild it with that --wl-max\n", name, (unsigned long long) hdr->wl_cnt, wl_max);
+
+    return (-1);
+  }
+
+  if ((flags != -1) && (hdr->flags != (u32) flags))
+  {
+    char opts[64] = "";
+
+    if ((hdr->flags & PP_DB_DUPE_CHECK) == 0) strcat (opts, " -c");
+    if (hdr->flags & PP_DB_CASE_PERMUTE)      strcat (opts, " --case-permute");
+    if (hdr->flags & PP_DB_SORTED)            strcat (opts, " --dupe-mode=sort");
+
+    fprintf (stderr, "%s: Database was built with %s, the load options given differ\n", name, (opts[0]) ? opts + 1 : "the default load options");
+
+    return (-1);
+  }
+
+  if (wordlist && (db_check_src (hdr, name, wordlist) == -1)) return (-1);
+
+  for (int input_len = IN_LEN_MIN; input_len <= in_max; input_len++)
+  {
+    const pp_db_entry_t *entry = &hdr->entries[input_len];
+
+    if (entry->cnt == 0) continue;
+
+    const int valid = (entry->stride >= (u32) input_len)
+                   && (entry->stride <= PP_DB_PAGE)
+                   && ((entry->off % PP_DB_PAGE) == 0)
+                   && (entry->off <= size)
+                   && (entry->cnt <= (size - entry->off) / entry->stride)
+                   && (entry->cnt * entry->stride + PP_DB_PAD <= size - entry->off);
+
+    if (valid == 0)
+    {
+      fprintf (stderr, "%s: Database entry for length %d is corrupt\n", name, input_len);
+
+      return (-1);
+    }
+
+    db_entry_t *db_entry = &db_entries[input_len];
+
+    db_entry->elems_buf    = map + entry->off;
+    db_entry->elems_cnt    = entry->cnt;
+    db_entry->elems_alloc  = entry->cnt;
+    db_entry->elems_stride = (int) entry->stride;
+  }
+
+  return 0;
+}
+
+static void catch_int (int signum)
+{
+  if (out_active && (stop_sig == 0) && (signum != 0))
+  {
+    // finish the current output buffer first so the saved position is exact
+
+    stop_sig = signum;
+
+    return;
+  }
+
+  FILE *fp = fopen (SAVE_FILE, "w");
+
+  if (fp == NULL) fp = stderr;
+
+  mpz_out_str (fp, 10, save);
+
+  fprintf (fp, "\n");
+
+  fclose (fp);
+
+  exit (signum==0?0:signum);
+}
+
+int main (int argc, char *argv[])
+{
+  mpz_t pw_ks_pos[OUT_LEN_MAX + 1];
+  mpz_t pw_ks_cnt[OUT_LEN_MAX + 1];
+
+  mpz_t total_ks_cnt;     mpz_init_set_si (total_ks_cnt,    0);
+  mpz_t total_ks_pos;     mpz_init_set_si (total_ks_pos,    0);
+  mpz_t skip;             mpz_init_set_si (skip,            0);
+  mpz_t limit;            mpz_init_set_si (limit,           0);
+  mpz_t tmp;              mpz_init_set_si (tmp,             0);
+
+  int     version          = 0;
+  int     usage            = 0;
+  int     keyspace         = 0;
+  int     pw_min           = PW_MIN;
+  int     pw_max           = PW_MAX;
+  int     elem_cnt_min     = ELEM_CNT_MIN;
+  int     elem_cnt_max     = ELEM_CNT_MAX;
+  int     wl_dist_len      = WL_DIST_LEN;
+  int     wl_max           = WL_MAX;
+  int     case_permute     = CASE_PERMUTE;
+  int     dupe_check       = DUPE_CHECK;
+  int     dupe_mode        = DUPE_MODE;
+  char   *dupe_modestr     = NULL;
+  char   *build_db         = NULL;
+  char   *db_file          = NULL;
+  int     save_pos         = SAVE_POS;
+  int     writer_thread    = WRITER_THREAD;
+  int     output_splice    = OUTPUT_SPLICE;
+  int     output_uring     = OUTPUT_URING;
+  int     output_mmap      = OUTPUT_MMAP;
+  int     output_format    = OUTPUT_FORMAT;
+  char   *output_fmtstr    = NULL;
+  char   *output_shm       = NULL;
+  int     output_blocks    = 0;
+  char   *output_split     = NULL;
+  int     output_compress  = OUTPUT_COMPRESS;
+  int     compress_threads = COMPRESS_THREADS;
+  int     threads          = THREADS;
+  int     unordered        = UNORDERED;
+  int     order_tile_kb    = ORDER_TILE;
+  int     jit              = JIT;
+  int     load_threads     = LOAD_THREADS;
+  char   *output_file      = NULL;
+
+  #define IDX_VERSION               'V'
+  #define IDX_USAGE                 'h'
+  #define IDX_PW_MIN                0x1000
+  #define IDX_PW_MAX                0x2000
+  #define IDX_ELEM_CNT_MIN          0x3000
+  #define IDX_ELEM_CNT_MAX          0x4000
+  #define IDX_KEYSPACE              0x5000
+  #define IDX_WL_DIST_LEN           0x6000
+  #define IDX_WL_MAX                0x7000
+  #define IDX_CASE_PERMUTE          0x8000
+  #define IDX_SAVE_POS_DISABLE      0x9000
+  #define IDX_WRITER_THREAD         0xa000
+  #define IDX_OUTPUT_SPLICE         0xb000
+  #define IDX_OUTPUT_URING          0xc000
+  #define IDX_OUTPUT_MMAP           0xd000
+  #define IDX_OUTPUT_FORMAT         0xe000
+  #define IDX_OUTPUT_SHM            0xf000
+  #define IDX_OUTPUT_BLOCKS         0x10000
+  #define IDX_OUTPUT_SPLIT_LEN      0x11000
+  #define IDX_OUTPUT_COMPRESS       0x12000
+  #define IDX_COMPRESS_THREADS      0x13000
+  #define IDX_THREADS               0x14000
+  #define IDX_UNORDERED             0x15000
+  #define IDX_ORDER_TILE            0x16000
+  #define IDX_JIT                   0x17000
+  #define IDX_LOAD_THREADS          0x18000
+  #define IDX_DUPE_MODE             0x19000
+  #define IDX_BUILD_DB              0x1a000
+  #define IDX_DB                    0x1b000
+  #define IDX_DUPE_CHECK_DISABLE    'c'
+  #define IDX_SKIP                  's'
+  #define IDX_LIMIT                 'l'
+  #define IDX_OUTPUT_FILE           'o'
+
+  struct option long_options[] =
+  {
+    {"version",               no_argument,       0, IDX_VERSION},
+    {"help",                  no_argument,       0, IDX_USAGE},
+    {"keyspace",              no_argument,       0, IDX_KEYSPACE},
+    {"pw-min",                required_argument, 0, IDX_PW_MIN},
+    {"pw-max",                required_argument, 0, IDX_PW_MAX},
+    {"elem-cnt-min",          required_argument, 0, IDX_ELEM_CNT_MIN},
+    {"elem-cnt-max",          required_argument, 0, IDX_ELEM_CNT_MAX},
+    {"wl-dist-len",           no_argument,       0, IDX_WL_DIST_LEN},
+    {"wl-max",                required_argument, 0, IDX_WL_MAX},
+    {"case-permute",          no_argument,       0, IDX_CASE_PERMUTE},
+    {"dupe-check-disable",    no_argument,       0, IDX_DUPE_CHECK_DISABLE},
+    {"save-pos-disable",      no_argument,       0, IDX_SAVE_POS_DISABLE},
+    {"skip",                  required_argument, 0, IDX_SKIP},
+    {"limit",                 required_argument, 0, IDX_LIMIT},
+    {"output-file",           required_argument, 0, IDX_OUTPUT_FILE},
+    {"writer-thread",         no_argument,       0, IDX_WRITER_THREAD},
+    {"output-splice",         no_argument,       0, IDX_OUTPUT_SPLICE},
+    {"output-uring",          no_argument,       0, IDX_OUTPUT_URING},
+    {"output-mmap",           no_argument,       0, IDX_OUTPUT_MMAP},
+    {"output-format",         required_argument, 0, IDX_OUTPUT_FORMAT},
+    {"output-shm",            required_argument, 0, IDX_OUTPUT_SHM},
+    {"output-blocks",         required_argument, 0, IDX_OUTPUT_BLOCKS},
+    {"output-split-len",      required_argument, 0, IDX_OUTPUT_SPLIT_LEN},
+    {"output-compress",       no_argument,       0, IDX_OUTPUT_COMPRESS},
+    {"compress-threads",      required_argument, 0, IDX_COMPRESS_THREADS},
+    {"threads",               required_argument, 0, IDX_THREADS},
+    {"unordered",             no_argument,       0, IDX_UNORDERED},
+    {"order-tile",            required_argument, 0, IDX_ORDER_TILE},
+    {"jit",                   no_argument,       0, IDX_JIT},
+    {"load-threads",          required_argument, 0, IDX_LOAD_THREADS},
+    {"dupe-mode",             required_argument, 0, IDX_DUPE_MODE},
+    {"build-db",              required_argument, 0, IDX_BUILD_DB},
+    {"db",                    required_argument, 0, IDX_DB},
+    {0, 0, 0, 0}
+  };
+
+  int elem_cnt_max_chgd = 0;
+  int load_opts_chgd    = 0;
+
+  int option_index = 0;
+
+  int c;
+
+  while ((c = getopt_long (argc, argv, "Vhs:l:o:c", long_options, &option_index)) != -1)
+  {
+    switch (c)
+    {
+      case IDX_VERSION:               version           = 1;              break;
+      case IDX_USAGE:                 usage             = 1;              break;
+      case IDX_KEYSPACE:              keyspace          = 1;              break;
+      case IDX_PW_MIN:                pw_min            = atoi (optarg);  break;
+      case IDX_PW_MAX:                pw_max            = atoi (optarg);  break;
+      case IDX_ELEM_CNT_MIN:          elem_cnt_min      = atoi (optarg);  break;
+      case IDX_ELEM_CNT_MAX:          elem_cnt_max      = atoi (optarg);
+                                      elem_cnt_max_chgd = 1;              break;
+      case IDX_WL_DIST_LEN:           wl_dist_len       = 1;              break;
+      case IDX_WL_MAX:                wl_max            = atoi (optarg);  break;
+      case IDX_CASE_PERMUTE:          case_permute      = 1;
+                                      load_opts_chgd    = 1;              break;
+      case IDX_DUPE_CHECK_DISABLE:    dupe_check        = 0;
+                                      load_opts_chgd    = 1;              break;
+      case IDX_SAVE_POS_DISABLE:      save_pos          = 0;              break;
+      case IDX_SKIP:                  mpz_set_str (skip,  optarg, 10);    break;
+      case IDX_LIMIT:                 mpz_set_str (limit, optarg, 10);    break;
+      case IDX_OUTPUT_FILE:           output_file       = optarg;         break;
+      case IDX_WRITER_THREAD:         writer_thread     = 1;              break;
+      case IDX_OUTPUT_SPLICE:         output_splice     = 1;              break;
+      case IDX_OUTPUT_URING:          output_uring      = 1;              break;
+      case IDX_OUTPUT_MMAP:           output_mmap       = 1;              break;
+      case IDX_OUTPUT_FORMAT:         output_fmtstr     = optarg;         break;
+      case IDX_OUTPUT_SHM:            output_shm        = optarg;         break;
+      case IDX_OUTPUT_BLOCKS:         output_blocks     = atoi (optarg);  break;
+      case IDX_OUTPUT_SPLIT_LEN:      output_split      = optarg;         break;
+      case IDX_OUTPUT_COMPRESS:       output_compress   = 1;              break;
+      case IDX_COMPRESS_THREADS:      compress_threads  = atoi (optarg);  break;
+      case IDX_THREADS:               threads           = atoi (optarg);  break;
+      case IDX_UNORDERED:             unordered         = 1;              break;
+      case IDX_ORDER_TILE:            order_tile_kb     = atoi (optarg);  break;
+      case IDX_JIT:                   jit               = 1;              break;
+      case IDX_LOAD_THREADS:          load_threads      = atoi (optarg);  break;
+      case IDX_DUPE_MODE:             dupe_modestr      = optarg;
+                                      load_opts_chgd    = 1;              break;
+      case IDX_BUILD_DB:              build_db          = optarg;         break;
+      case IDX_DB:                    db_file           = optarg;         break;
+
+      default: return (-1);
+    }
+  }
+
+  if (elem_cnt_max_chgd == 0)
+  {
+    elem_cnt_max = MIN (pw_max, ELEM_CNT_MAX);
+  }
+
+  if (usage)
+  {
+    usage_big_print (argv[0]);
+
+    return (-1);
+  }
+
+  if (version)
+  {
+    printf ("v%4.02f\n", (double) VERSION_BIN / 100);
+
+    return (-1);
+  }
+
+  if ((optind != argc) && (optind + 1 != argc))
+  {
+    usage_mini_print (argv[0]);
+
+    return (-1);
+  }
+
+  char *wordlist = NULL;
+
+  if (optind + 1 == argc)
+  {
+    wordlist = argv[optind];
+  }
+
+  if (pw_min <= 0)
+  {
+    fprintf (stderr, "Value of --pw-min (%d) must be greater than %d\n", pw_min, 0);
+
+    return (-1);
+  }
+
+  if (pw_max <= 0)
+  {
+    fprintf (stderr, "Value of --pw-max (%d) must be greater than %d\n", pw_max, 0);
+
+    return (-1);
+  }
+
+  if (elem_cnt_min <= 0)
+  {
+    fprintf (stderr, "Value of --elem-cnt-min (%d) must be greater than %d\n", elem_cnt_min, 0);
+
+    return (-1);
+  }
+
+  if (elem_cnt_max < (1 - pw_max))
+  {
+    fprintf (stderr, "Value of --elem-cnt-max (%d) must be greater than %d\n", elem_cnt_max, (0 - pw_max));
+
+    return (-1);
+  }
+
+  if (pw_min > pw_max)
+  {
+    fprintf (stderr, "Value of --pw-min (%d) must be smaller or equal than value of --pw-max (%d)\n", pw_min, pw_max);
+
+    return (-1);
+  }
+
+  if (elem_cnt_max > 0 && elem_cnt_min > elem_cnt_max)
+  {
+    fprintf (stderr, "Value of --elem-cnt-min (%d) must be smaller or equal than value of --elem-cnt-max (%d)\n", elem_cnt_min, elem_cnt_max);
+
+    return (-1);
+  }
+
+  if (pw_min < IN_LEN_MIN)
+  {
+    fprintf (stderr, "Value of --pw-min (%d) must be greater or equal than %d\n", pw_min, IN_LEN_MIN);
+
+    return (-1);
+  }
+
+  if (pw_max > OUT_LEN_MAX)
+  {
+    fprintf (stderr, "Value of --pw-max (%d) must be smaller or equal than %d\n", pw_max, OUT_LEN_MAX);
+
+    return (-1);
+  }
+
+  if (elem_cnt_max > pw_max)
+  {
+    fprintf (stderr, "Value of --elem-cnt-max (%d) must be smaller or equal than value of --pw-max (%d)\n", elem_cnt_max, pw_max);
+
+    return (-1);
+  }
+
+  if (output_fmtstr)
+  {
+    if      (strcmp (output_fmtstr, "plain") == 0) output_format = OUT_FORMAT_PLAIN;
+    else if (strcmp (output_fmtstr, "nul")   == 0) output_format = OUT_FORMAT_NUL;
+    else if (strcmp (output_fmtstr, "len8")  == 0) output_format = OUT_FORMAT_LEN8;
+    else if (strcmp (output_fmtstr, "fixed") == 0) output_format = OUT_FORMAT_FIXED;
+    else if (strcmp (output_fmtstr, "pw_t")  == 0) output_format = OUT_FORMAT_PW_T;
+    else if (strcmp (output_fmtstr, "front") == 0) output_format = OUT_FORMAT_FRONT;
+    else
+    {
+      fprintf (stderr, "Value of --output-format (%s) is unknown\n", output_fmtstr);
+
+      return (-1);
+    }
+  }
+
+  if (dupe_modestr)
+  {
+    if      (strcmp (dupe_modestr, "hash")            == 0) dupe_mode = DUPE_MODE_HASH;
+    else if (strcmp (dupe_modestr, "sort")            == 0) dupe_mode = DUPE_MODE_SORT;
+    else if (strcmp (dupe_modestr, "sort-keep-order") == 0) dupe_mode = DUPE_MODE_SORT_KEEP;
+    else
+    {
+      fprintf (stderr, "Value of --dupe-mode (%s) is unknown\n", dupe_modestr);
+
+      return (-1);
+    }
+  }
+
+  if (db_file && build_db)
+  {
+    fprintf (stderr, "Options --db and --build-db are mutually exclusive\n");
+
+    return (-1);
+  }
+
+  int output_stride = 1;
+
+  while (output_stride < pw_max) output_stride <<= 1;
+
+  if (output_mmap && (output_file == NULL) && (output_split == NULL))
+  {
+    fprintf (stderr, "Option --output-mmap requires --output-file or --output-split-len\n");
+
+    return (-1);
+  }
+
+  if ((output_format == OUT_FORMAT_FRONT) && (output_mmap || output_blocks))
+  {
+    fprintf (stderr, "Option --output-format=front cannot be used together with --output-mmap or --output-blocks\n");
+
+    return (-1);
+  }
+
+  if ((compress_threads < 1) || (compress_threads > OUT_LZ_THREADS_MAX))
+  {
+    fprintf (stderr, "Value of --compress-threads (%d) must be between 1 and %d\n", compress_threads, OUT_LZ_THREADS_MAX);
+
+    return (-1);
+  }
+
+  if ((threads < 1) || (threads > GEN_THREADS_MAX))
+  {
+    fprintf (stderr, "Value of --threads (%d) must be between 1 and %d\n", threads, GEN_THREADS_MAX);
+
+    return (-1);
+  }
+
+  if ((load_threads < 1) || (load_threads > IN_THREADS_MAX))
+  {
+    fprintf (stderr, "Value of --load-threads (%d) must be between 1 and %d\n", load_threads, IN_THREADS_MAX);
+
+    return (-1);
+  }
+
+  if (unordered && (threads == 1))
+  {
+    fprintf (stderr, "Option --unordered requires --threads greater than 1\n");
+
+    return (-1);
+  }
+
+  if (unordered && (writer_thread || output_compress || output_splice || output_uring || output_mmap || output_shm || output_blocks || output_split || (output_format == OUT_FORMAT_FRONT)))
+  {
+    fprintf (stderr, "Option --unordered lets every thread write the output itself, it cannot be used together with --writer-thread, --output-compress, --output-splice, --output-uring, --output-mmap, --output-shm, --output-blocks, --output-split-len or --output-format=front\n");
+
+    return (-1);
+  }
+
+  if ((order_tile_kb < 0) || (order_tile_kb > ORDER_TILE_MAX))
+  {
+    fprintf (stderr, "Value of --order-tile (%d) must be between 0 and %d\n", order_tile_kb, ORDER_TILE_MAX);
+
+    return (-1);
+  }
+
+  order_tile = (u64) order_tile_kb * 1024;
+
+  if (output_compress && (writer_thread || output_splice || output_uring || output_mmap || output_shm || output_blocks || output_split))
+  {
+    fprintf (stderr, "Option --output-compress cannot be used together with other output modes\n");
+
+    return (-1);
+  }
+
+  if (output_split && (output_file || output_shm || output_splice))
+  {
+    fprintf (stderr, "Option --output-split-len cannot be used together with --output-file, --output-shm or --output-splice\n");
+
+    return (-1);
+  }
+
+  if ((output_blocks < 0) || (output_blocks > OUT_BLOCKS_MAX))
+  {
+    fprintf (stderr, "Value of --output-blocks (%d) must be between 0 (off) and %d\n", output_blocks, OUT_BLOCKS_MAX);
+
+    return (-1);
+  }
+
+  if (output_blocks && output_shm)
+  {
+    fprintf (stderr, "Option --output-blocks cannot be used together with --output-shm\n");
+
+    return (-1);
+  }
+
+  if (output_shm && (output_file != NULL))
+  {
+    fprintf (stderr, "Option --output-shm cannot be used together with --output-file\n");
+
+    return (-1);
+  }
+
+  if (output_shm)
+  {
+    if (output_fmtstr && (output_format != OUT_FORMAT_PW_T))
+    {
+      fprintf (stderr, "Option --output-shm requires --output-format=pw_t\n");
+
+      return (-1);
+    }
+
+    output_format = OUT_FORMAT_PW_T;
+  }
+
+  #ifndef LINUX
+  if (output_mmap)
+  {
+    fprintf (stderr, "Option --output-mmap is not supported on this platform\n");
+
+    return (-1);
+  }
+
+  if (output_shm)
+  {
+    fprintf (stderr, "Option --output-shm is not supported on this platform\n");
+
+    return (-1);
+  }
+  #endif
+
+  /**
+   * OS specific settings
+   */
+
+  #ifdef WINDOWS
+  setmode (fileno (stdout), O_BINARY);
+  #endif
+
+  /**
+   * alloc some space
+   */
+
+  // a database serves any --pw-max later, it keeps every length
+
+  if (build_db) pw_max = IN_LEN_MAX;
+
+  db_entry_t *db_entries   = (db_entry_t *) calloc (pw_max + 1, sizeof (db_entry_t));
+  pw_order_t *pw_orders    = (pw_order_t *) calloc (pw_max + 1, sizeof (pw_order_t));
+  u64        *wordlen_dist = (u64 *)        calloc (pw_max + 1, sizeof (u64));
+
+  out_t *out = (out_t *) mem_alloc (sizeof (out_t));
+
+  if (dupe_check && (dupe_mode == DUPE_MODE_HASH) && (db_file == NULL))
+  {
+    int in_max = MIN(IN_LEN_MAX, pw_max);
+
+    for (int pw_len = IN_LEN_MIN; pw_len <= in_max; pw_len++)
+    {
+      db_entry_t *db_entry = &db_entries[pw_len];
+
+      db_entry->uniq = uniq_alloc ();
+    }
+  }
+
+  /**
+   * files
+   */
+
+  FILE *out_fp = stdout;
+
+  if (output_file)
+  {
+    // mmap() needs the file to be readable, too
+
+    out_fp = fopen (output_file, (output_mmap) ? "a+b" : "ab");
+
+    if (out_fp == NULL)
+    {
+      fprintf (stderr, "%s: %s\n", output_file, strerror (errno));
+
+      return (-1);
+    }
+  }
+
+  /*
+   * catch signal user interrupt
+   */
+
+  if (save_pos)
+  {
+    signal (SIGINT, catch_int);
+  }
+
+  /**
+   * load elems from stdin
+   */
+
+  simd_level = pp_simd_level ();
+
+  u8 *db_map  = NULL;
+  u64 db_size = 0;
+
+  pp_db_sum_t sum;
+
+  pp_db_sum_init (&sum);
+
+  in_t in;
+
+  u32 db_flags = 0;
+
+  if (dupe_check)                                  db_flags |= PP_DB_DUPE_CHECK;
+  if (case_permute)                                db_flags |= PP_DB_CASE_PERMUTE;
+  if (dupe_check && (dupe_mode == DUPE_MODE_SORT)) db_flags |= PP_DB_SORTED;
+
+  if (db_file)
+  {
+    // the load options of the build apply, given ones have to match them
+
+    const int flags = (load_opts_chgd) ? (int) db_flags : -1;
+
+    if (db_load (db_entries, MIN(IN_LEN_MAX, pw_max), db_file, wordlist, flags, wl_max, &db_map, &db_size) == -1) return (-1);
+  }
+  else
+  {
+    FILE *read_fp = stdin;
+
+    if (wordlist)
+    {
+      read_fp = fopen (wordlist, "rb");
+
+      if (read_fp == NULL)
+      {
+        fprintf (stderr, "%s: %s\n", wordlist, strerror (errno));
+
+        return (-1);
+      }
+    }
+
+    in.db_entries   = db_entries;
+    in.pw_max       = pw_max;
+    in.dupe_check   = dupe_check && (dupe_mode == DUPE_MODE_HASH);
+    in.case_permute = case_permute;
+    in.wl_max       = wl_max;
+    in.wl_cnt       = 0;
+    in.threads      = load_threads;
+    in.shards       = NULL;
+    in.sum          = (build_db) ? &sum : NULL;
+
+    if (in_load (&in, read_fp, (wordlist) ? wordlist : "stdin") == -1) return (-1);
+
+    if (wordlist)
+    {
+      fclose (read_fp);
+    }
+
+    if (dupe_check && (dupe_mode != DUPE_MODE_HASH))
+    {
+      dupe_sort (db_entries, MIN(IN_LEN_MAX, pw_max), dupe_mode == DUPE_MODE_SORT_KEEP, load_threads);
+    }
+    else if (dupe_check)
+    {
+      int in_max = MIN(IN_LEN_MAX, pw_max);
+
+      for (int pw_len = IN_LEN_MIN; pw_len <= in_max; pw_len++)
+      {
+        db_entry_t *db_entry = &db_entries[pw_len];
+
+        uniq_free (db_entry->uniq);
+
+        db_entry->uniq = NULL;
+      }
+    }
+  }
+
+  if (build_db)
+  {
+    const int rc = db_build (db_entries, &in, db_flags, build_db);
+
+    for (int pw_len = IN_LEN_MIN; pw_len <= IN_LEN_MAX; pw_len++)
+    {
+      free (db_entries[pw_len].elems_buf);
+    }
+
+    free (out);
+    free (wordlen_dist);
+    free (pw_orders);
+    free (db_entries);
+
+    return rc;
+  }
+
+  /**
+   * init chains
+   */
+
+  for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+  {
+    db_entry_t *db_entry = &db_entries[pw_len];
+
+    const int pw_len1 = pw_len - 1;
+
+    const u32 chains_cnt = 1 << pw_len1;
+
+    u8 buf[OUT_LEN_MAX];
+
+    chain_t chain_buf_new;
+
+    chain_buf_new.buf = buf;
+
+    for (u32 chains_idx = 0; chains_idx < chains_cnt; chains_idx++)
+    {
+      chain_gen_with_idx (&chain_buf_new, pw_len1, chains_idx);
+
+      // make sure all the elements really exist
+
+      int valid1 = chain_valid_with_db (&chain_buf_new, db_entries);
+
+      if (valid1 == 0) continue;
+
+      // boost by verify element count to be inside a specific range
+
+      int valid2 = chain_valid_with_cnt_min (&chain_buf_new, elem_cnt_min);
+
+      if (valid2 == 0) continue;
+
+      int eff_elem_cnt_max;
+
+      if (elem_cnt_max > 0)
+      {
+        eff_elem_cnt_max = elem_cnt_max;
+      }
+      else
+      {
+        eff_elem_cnt_max = pw_len + elem_cnt_max;
+
+        if (eff_elem_cnt_max <= elem_cnt_min) continue;
+      }
+
+      int valid3 = chain_valid_with_cnt_max (&chain_buf_new, eff_elem_cnt_max);
+
+      if (valid3 == 0) continue;
+
+      // add chain to database
+
+      check_realloc_chains (db_entry);
+
+      chain_t *chain_buf = &db_entry->chains_buf[db_entry->chains_cnt];
+
+      memcpy (chain_buf, &chain_buf_new, sizeof (chain_t));
+
+      chain_buf->buf = malloc_tiny (pw_len);
+
+      memcpy (chain_buf->buf, chain_buf_new.buf, pw_len);
+
+      mpz_init_set_si (chain_buf->ks_cnt, 0);
+      mpz_init_set_si (chain_buf->ks_pos, 0);
+
+      db_entry->chains_cnt++;
+    }
+
+    memset (db_entry->cur_chain_ks_poses, 0, OUT_LEN_MAX * sizeof (u64));
+  }
+
+  /**
+   * calculate password candidate output length distribution
+   */
+
+  if (wl_dist_len)
+  {
+    for (int pw_len = IN_LEN_MIN; pw_len <= pw_max; pw_len++)
+    {
+      if (pw_len <= IN_LEN_MAX)
+      {
+        db_entry_t *db_entry = &db_entries[pw_len];
+
+        wordlen_dist[pw_len] = db_entry->elems_cnt;
+      }
+      else
+      {
+        wordlen_dist[pw_len] = 1;
+      }
+    }
+  }
+  else
+  {
+    for (int pw_len = IN_LEN_MIN; pw_len <= pw_max; pw_len++)
+    {
+      if (pw_len < DEF_WORDLEN_DIST_CNT)
+      {
+        wordlen_dist[pw_len] = DEF_WORDLEN_DIST[pw_len];
+      }
+      else
+      {
+        wordlen_dist[pw_len] = 1;
+      }
+    }
+  }
+
+  /**
+   * Calculate keyspace stuff
+   */
+
+  for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+  {
+    db_entry_t *db_entry = &db_entries[pw_len];
+
+    int      chains_cnt = db_entry->chains_cnt;
+    chain_t *chains_buf = db_entry->chains_buf;
+
+    mpz_set_si (tmp, 0);
+
+    for (int chains_idx = 0; chains_idx < chains_cnt; chains_idx++)
+    {
+      chain_t *chain_buf = &chains_buf[chains_idx];
+
+      chain_ks (chain_buf, db_entries, &chain_buf->ks_cnt);
+
+      mpz_add (tmp, tmp, chain_buf->ks_cnt);
+    }
+
+    mpz_add (total_ks_cnt, total_ks_cnt, tmp);
+
+    mpz_init_set (pw_ks_cnt[pw_len], tmp);
+  }
+
+  if (total_ks_cnt == UINT128_MAX)
+  {
+    fprintf (stderr, "Warning: %d-bit keyspace saturated\n", FAKE_GMP);
+  }
+
+  if (keyspace)
+  {
+    mpz_out_str (stdout, 10, total_ks_cnt);
+
+    printf ("\n");
+
+    return 0;
+  }
+
+  /**
+   * sort chains by ks
+   */
+
+  for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+  {
+    db_entry_t *db_entry = &db_entries[pw_len];
+
+    chain_t *chains_buf = db_entry->chains_buf;
+
+    const int chains_cnt = db_entry->chains_cnt;
+
+    qsort (chains_buf, chains_cnt, sizeof (chain_t), sort_by_ks);
+  }
+
+  /**
+   * sort global order by password length counts
+   */
+
+  for (int pw_len = pw_min, order_pos = 0; pw_len <= pw_max; pw_len++, order_pos++)
+  {
+    db_entry_t *db_entry = &db_entries[pw_len];
+
+    const u64 elems_cnt = db_entry->elems_cnt;
+
+    pw_order_t *pw_order = &pw_orders[order_pos];
+
+    pw_order->len = pw_len;
+    pw_order->cnt = elems_cnt;
+  }
+
+  const int order_cnt = pw_max + 1 - pw_min;
+
+  qsort (pw_orders, order_cnt, sizeof (pw_order_t), sort_by_cnt);
+
+  /**
+   * seek to some starting point
+   */
+
+  if (mpz_cmp_si (skip, 0))
+  {
+    if (mpz_cmp (skip, total_ks_cnt) >= 0)
+    {
+      fprintf (stderr, "Value of --skip must be smaller than total keyspace\n");
+
+      return (-1);
+    }
+  }
+
+  if (mpz_cmp_si (limit, 0))
+  {
+    if (mpz_cmp (limit, total_ks_cnt) > 0)
+    {
+      fprintf (stderr, "Value of --limit cannot be larger than total keyspace\n");
+
+      return (-1);
+    }
+
+    mpz_add (tmp, skip, limit);
+
+    if (mpz_cmp (tmp, total_ks_cnt) > 0)
+    {
+      fprintf (stderr, "Value of --skip + --limit cannot be larger than total keyspace\n");
+
+      return (-1);
+    }
+
+    mpz_set (total_ks_cnt, tmp);
+  }
+
+  mpz_init_set (save, skip);
+
+  // output size of each length, total size in [0], only --output-mmap
+  // needs them
+
+  #ifdef LINUX
+  mpz_t out_len_sizes[OUT_LEN_MAX + 1];
+
+  for (int pw_len = 0; pw_len <= pw_max; pw_len++)
+  {
+    mpz_init_set_si (out_len_sizes[pw_len], 0);
+  }
+  #endif
+
+  if (output_mmap)
+  {
+    #ifdef LINUX
+    // we know the length of every candidate we are going to write
+
+    mpz_t pw_cnts_beg[OUT_LEN_MAX + 1];
+    mpz_t pw_cnts_end[OUT_LEN_MAX + 1];
+
+    pw_cnts_at_pos (skip,         pw_cnts_beg, pw_ks_cnt, wordlen_dist, pw_orders, order_cnt, pw_min, pw_max);
+    pw_cnts_at_pos (total_ks_cnt, pw_cnts_end, pw_ks_cnt, wordlen_dist, pw_orders, order_cnt, pw_min, pw_max);
+
+    mpz_t out_size; mpz_init_set_si (out_size, 0);
+
+    for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+    {
+      mpz_sub (tmp, pw_cnts_end[pw_len], pw_cnts_beg[pw_len]);
+
+      mpz_clear (pw_cnts_beg[pw_len]);
+      mpz_clear (pw_cnts_end[pw_len]);
+
+      if (mpz_cmp_si (tmp, 0) == 0) continue;
+
+      mpz_set (out_len_sizes[pw_len], out_size);
+
+      if (output_blocks)
+      {
+        // one header per started block
+
+        mpz_t blocks; mpz_init (blocks);
+
+        mpz_add_ui (blocks, tmp, (u64) output_blocks - 1);
+
+        mpz_div_ui (blocks, blocks, output_blocks);
+
+        mpz_mul_ui (blocks, blocks, sizeof (out_block_hdr_t));
+
+        mpz_add (out_size, out_size, blocks);
+
+        mpz_clear (blocks);
+      }
+
+      mpz_mul_ui (tmp, tmp, (u64) out_rec_len (output_format, output_stride, pw_len));
+
+      mpz_add (out_size, out_size, tmp);
+
+      // size of this length alone, for --output-split-len
+
+      mpz_sub (out_len_sizes[pw_len], out_size, out_len_sizes[pw_len]);
+    }
+
+    if (mpz_cmp_ui (out_size, (u64) INT64_MAX) > 0)
+    {
+      fprintf (stderr, "Output too large for --output-mmap\n");
+
+      return (-1);
+    }
+
+    mpz_set (out_len_sizes[0], out_size);
+
+    mpz_clear (out_size);
+    #endif
+  }
+
+  if (output_split)
+  {
+    // every length gets its own writer below, out stays unused
+  }
+  else if (output_mmap)
+  {
+    #ifdef LINUX
+    out_init_mmap (out, out_fp, mpz_get_ui (out_len_sizes[0]));
+    #endif
+  }
+  else if (output_shm)
+  {
+    #ifdef LINUX
+    out_init_shm (out, output_shm);
+    #endif
+  }
+  else if (output_compress)
+  {
+    out_init_compress (out, out_fp, compress_threads, output_format, skip);
+  }
+  else
+  {
+    out_init (out, out_fp, writer_thread, output_splice, output_uring);
+  }
+
+  out_t *out_split = NULL;
+
+  if (output_split)
+  {
+    out_split = (out_t *) calloc (pw_max + 1, sizeof (out_t));
+
+    // DIR, a slash and the length
+
+    const size_t split_size = strlen (output_split) + 16;
+
+    char *split_file = (char *) mem_alloc (split_size);
+
+    for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+    {
+      if (mpz_cmp_si (pw_ks_cnt[pw_len], 0) == 0) continue;
+
+      snprintf (split_file, split_size, "%s/%d", output_split, pw_len);
+
+      FILE *split_fp = fopen (split_file, (output_mmap) ? "a+b" : "ab");
+
+      if (split_fp == NULL)
+      {
+        fprintf (stderr, "%s: %s\n", split_file, strerror (errno));
+
+        return (-1);
+      }
+
+      if (output_mmap)
+      {
+        #ifdef LINUX
+        out_init_mmap (&out_split[pw_len], split_fp, mpz_get_ui (out_len_sizes[pw_len]));
+        #endif
+      }
+      else
+      {
+        out_init (&out_split[pw_len], split_fp, writer_thread, 0, output_uring);
+      }
+    }
+
+    free (split_file);
+  }
+
+  #ifdef LINUX
+  for (int pw_len = 0; pw_len <= pw_max; pw_len++)
+  {
+    mpz_clear (out_len_sizes[pw_len]);
+  }
+  #endif
+
+  /**
+   * skip to the first main loop that will output a password
+   */
+
+  if (mpz_cmp_si (skip, 0))
+  {
+    mpz_t skip_left;  mpz_init (skip_left);
+
+    seek_main_loops (skip, &skip_left, pw_ks_pos, pw_ks_cnt, wordlen_dist, pw_min, pw_max);
+
+    mpz_sub (total_ks_pos, skip, skip_left);
+
+    // set db_entries to pw_ks_pos[]
+
+    for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+    {
+      db_entry_t *db_entry = &db_entries[pw_len];
+
+      int      chains_cnt = db_entry->chains_cnt;
+      chain_t *chains_buf = db_entry->chains_buf;
+
+      mpz_set (tmp, pw_ks_pos[pw_len]);
+
+      for (int chains_idx = 0; chains_idx < chains_cnt; chains_idx++)
+      {
+        chain_t *chain_buf = &chains_buf[chains_idx];
+
+        if (mpz_cmp (tmp, chain_buf->ks_cnt) < 0)
+        {
+          mpz_set (chain_buf->ks_pos, tmp);
+
+          set_chain_ks_poses (chain_buf, db_entries, &tmp, db_entry->cur_chain_ks_poses);
+
+          break;
+        }
+
+        mpz_sub (tmp, tmp, chain_buf->ks_cnt);
+
+        db_entry->chains_pos++;
+      }
+    }
+
+    // clean up
+
+    for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+    {
+      mpz_clear (pw_ks_pos[pw_len]);
+    }
+
+    mpz_clear (skip_left);
+  }
+
+  for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+  {
+    mpz_clear (pw_ks_cnt[pw_len]);
+  }
+
+  out_t *out_blocks = NULL;
+
+  if (output_blocks)
+  {
+    out_blocks = (out_t *) calloc (pw_max + 1, sizeof (out_t));
+
+    for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+    {
+      out_t *out_parent = (out_split) ? &out_split[pw_len] : out;
+
+      out_init_block (&out_blocks[pw_len], out_parent, pw_len, out_rec_len (output_format, output_stride, pw_len), output_blocks);
+    }
+  }
+
+  // the terminator of these formats is stored as an immediate
+
+  jit_enabled = jit;
+
+  if (output_format == OUT_FORMAT_PLAIN) jit_term = '\n';
+  if (output_format == OUT_FORMAT_NUL)   jit_term = 0;
+
+  gen_t *gen = NULL;
+
+  if (threads > 1)
+  {
+    gen = gen_init (db_entries, threads, output_format, unordered, out_fp);
+  }
+
+  /**
+   * loop
+   */
+
+  out_active = 1;
+
+  // the loop counts in u64, slices are never longer than wordlen_dist and
+  // the remaining counts only need 128-bit when they read UINT64_MAX
+
+  u64 total_ks_left = ks_left_u64 (total_ks_cnt, total_ks_pos);
+  u64 skip_left     = ks_left_u64 (skip,         total_ks_pos);
+
+  while ((total_ks_left > 0) && (stop_sig == 0))
+  {
+    for (int order_pos = 0; order_pos < order_cnt; order_pos++)
+    {
+      pw_order_t *pw_order = &pw_orders[order_pos];
+
+      const int pw_len = pw_order->len;
+
+      out_t *out_len = (out_blocks) ? &out_blocks[pw_len] : (out_split) ? &out_split[pw_len] : out;
+
+      char rec_buf[BUFSIZ];
+
+      const int rec_len = out_rec_init (rec_buf, output_format, output_stride, pw_len);
+
+      const int rec_off = out_rec_off (output_format);
+
+      char *pw_buf = rec_buf + rec_off;
+
+      db_entry_t *db_entry = &db_entries[pw_len];
+
+      const u64 outs_cnt = wordlen_dist[pw_len];
+
+      u64 outs_pos = 0;
+
+      while (outs_pos < outs_cnt)
+      {
+        const int chains_cnt = db_entry->chains_cnt;
+        const int chains_pos = db_entry->chains_pos;
+
+        if (chains_pos == chains_cnt) break;
+
+        chain_t *chains_buf = db_entry->chains_buf;
+
+        chain_t *chain_buf = &chains_buf[chains_pos];
+
+        if (db_entry->cur_chain_ks_left == 0)
+        {
+          db_entry->cur_chain_ks_left = ks_left_u64 (chain_buf->ks_cnt, chain_buf->ks_pos);
+        }
+
+        u64 iter_max_u64 = outs_cnt - outs_pos;
+
+        if (db_entry->cur_chain_ks_left < iter_max_u64) iter_max_u64 = db_entry->cur_chain_ks_left;
+
+        if (total_ks_left < iter_max_u64) iter_max_u64 = total_ks_left;
+
+        if (iter_max_u64 > skip_left)
+        {
+          u64 iter_pos_u64 = skip_left;
+
+          if (iter_pos_u64)
+          {
+            mpz_add_ui (tmp, chain_buf->ks_pos, iter_pos_u64);
+
+            set_chain_ks_poses (chain_buf, db_entries, &tmp, db_entry->cur_chain_ks_poses);
+
+            db_entry->chain_kern_chain = NULL;
+
+            skip_left = 0;
+          }
+
+          if (gen)
+          {
+            mpz_add_ui (tmp, chain_buf->ks_pos, iter_pos_u64);
+
+            gen_submit (gen, out_len, chain_buf, tmp, iter_max_u64 - iter_pos_u64, rec_buf, rec_len, rec_off, pw_len);
+
+            // workers keep their own positions, the next segment starts here
+
+            mpz_add_ui (tmp, chain_buf->ks_pos, iter_max_u64);
+
+            set_chain_ks_poses (chain_buf, db_entries, &tmp, db_entry->cur_chain_ks_poses);
+
+            db_entry->chain_kern_chain = NULL;
+          }
+          else
+          {
+            // segments of a length are often only a few candidates long,
+            // the kernel setup is kept until the chain changes
+
+            chain_kern_t *chain_kern = &db_entry->chain_kern;
+
+            if (db_entry->chain_kern_chain != chain_buf)
+            {
+              chain_kern_init (chain_kern, chain_buf, db_entries, db_entry->cur_chain_ks_poses);
+
+              db_entry->chain_kern_chain = chain_buf;
+            }
+
+            chain_set_pwbuf_init (chain_kern, pw_buf);
+
+            if (output_format == OUT_FORMAT_FRONT)
+            {
+              while (iter_pos_u64 < iter_max_u64)
+              {
+                out_push_front (out_len, pw_buf, pw_len);
+
+                chain_set_pwbuf_increment (chain_kern, pw_buf);
+
+                iter_pos_u64++;
+              }
+            }
+            else
+            {
+              out_push_chain (out_len, chain_kern, rec_buf, rec_len, rec_off, iter_max_u64 - iter_pos_u64);
+            }
+
+            chain_kern_save (chain_kern, db_entry->cur_chain_ks_poses);
+          }
+        }
+        else
+        {
+          mpz_add_ui (tmp, chain_buf->ks_pos, iter_max_u64);
+
+          set_chain_ks_poses (chain_buf, db_entries, &tmp, db_entry->cur_chain_ks_poses);
+
+          db_entry->chain_kern_chain = NULL;
+
+          skip_left = (skip_left == UINT64_MAX) ? UINT64_MAX : skip_left - iter_max_u64;
+        }
+
+        outs_pos += iter_max_u64;
+
+        mpz_add_ui (total_ks_pos, total_ks_pos, iter_max_u64);
+
+        mpz_add_ui (chain_buf->ks_pos, chain_buf->ks_pos, iter_max_u64);
+
+        total_ks_left = (total_ks_left == UINT64_MAX) ? ks_left_u64 (total_ks_cnt, total_ks_pos) : total_ks_left - iter_max_u64;
+
+        if (skip_left == UINT64_MAX) skip_left = ks_left_u64 (skip, total_ks_pos);
+
+        db_entry->cur_chain_ks_left = (db_entry->cur_chain_ks_left == UINT64_MAX) ? ks_left_u64 (chain_buf->ks_cnt, chain_buf->ks_pos) : db_entry->cur_chain_ks_left - iter_max_u64;
+
+        if (db_entry->cur_chain_ks_left == 0)
+        {
+          db_entry->chains_pos++;
+
+          memset (db_entry->cur_chain_ks_poses, 0, OUT_LEN_MAX * sizeof (u64));
+        }
+
+        if (total_ks_left == 0) break;
+
+        // stop between two chain segments, the saved position stays exact
+
+        if (stop_sig) break;
+      }
+
+      if (total_ks_left == 0) break;
+
+      if (stop_sig) break;
+    }
+  }
+
+  if (gen) gen_free (gen);
+
+  if (out_blocks)
+  {
+    for (int order_pos = 0; order_pos < order_cnt; order_pos++)
+    {
+      out_t *out_block = &out_blocks[pw_orders[order_pos].len];
+
+      out_flush (out_block);
+
+      out_close (out_block);
+    }
+
+    free (out_blocks);
+  }
+
+  if (out_split)
+  {
+    for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+    {
+      out_t *out_file = &out_split[pw_len];
+
+      if (out_file->fp == NULL) continue;
+
+      out_flush (out_file);
+
+      out_close (out_file);
+
+      fclose (out_file->fp);
+    }
+
+    free (out_split);
+  }
+  else
+  {
+    out_flush (out);
+
+    out_close (out);
+  }
+
+  out_active = 0;
+
+  if (save_pos)
+  {
+    catch_int (stop_sig);
+  }
+
+  /**
+   * cleanup
+   */
+
+  mpz_clear (total_ks_cnt);
+  mpz_clear (total_ks_pos);
+  mpz_clear (skip);
+  mpz_clear (limit);
+  mpz_clear (tmp);
+  mpz_clear (save);
+
+  for (int pw_len = pw_min; pw_len <= pw_max; pw_len++)
+  {
+    db_entry_t *db_entry = &db_entries[pw_len];
+
+    if (db_entry->chains_buf)
+    {
+      int      chains_cnt = db_entry->chains_cnt;
+      chain_t *chains_buf = db_entry->chains_buf;
+
+      for (int chains_idx = 0; chains_idx < chains_cnt; chains_idx++)
+      {
+        chain_t *chain_buf = &chains_buf[chains_idx];
+
+        mpz_clear (chain_buf->ks_cnt);
+        mpz_clear (chain_buf->ks_pos);
+      }
+
+      free (db_entry->chains_buf);
+    }
+
+    if (db_entry->elems_buf && (db_map == NULL)) free (db_entry->elems_buf);
+  }
+
+  if (db_map)
+  {
+    #ifdef LINUX
+    munmap (db_map, db_size);
+    #else
+    free (db_map);
+    #endif
+  }
+
+  prefixes_free ();
+
+  pp_jit_free ();
+
+  free (out);
+  free (wordlen_dist);
+  free (pw_orders);
+  free (db_entries);
+
+  return 0;
+}
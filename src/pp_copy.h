@@ -0,0 +1,113 @@
+#ifndef PP_COPY_H
+#define PP_COPY_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Copy kernels for elements of a known length
+ *
+ * Elements are 1 to PP_COPY_LEN_MAX bytes. A memcpy() with a runtime
+ * length goes through the generic library routine, which has to figure out
+ * the size class on every call. Each kernel here is compiled for one fixed
+ * length and moves it with at most four loads and stores, overlapping them
+ * for lengths that are not a power of two (7 bytes are two 4 byte moves at
+ * offsets 0 and 3). Nothing is read or written outside of the element.
+ *
+ * pp_copy_tab[len] selects the kernel, callers look it up once per element
+ * position and reuse it for every candidate of a chain.
+ */
+
+#define PP_COPY_LEN_MAX 32
+
+typedef void (*pp_copy_fn) (uint8_t *dst, const uint8_t *src);
+
+static inline __attribute__ ((always_inline)) void pp_copy_fixed (uint8_t *dst, const uint8_t *src, const int len)
+{
+  // len is a constant in every caller, so only one branch survives and the
+  // fixed size memcpy() calls become single loads and stores
+
+  if (len == 1)
+  {
+    dst[0] = src[0];
+  }
+  else if (len < 4)
+  {
+    uint16_t a;
+    uint16_t b;
+
+    memcpy (&a, src, 2);
+    memcpy (&b, src + len - 2, 2);
+
+    memcpy (dst, &a, 2);
+    memcpy (dst + len - 2, &b, 2);
+  }
+  else if (len < 8)
+  {
+    uint32_t a;
+    uint32_t b;
+
+    memcpy (&a, src, 4);
+    memcpy (&b, src + len - 4, 4);
+
+    memcpy (dst, &a, 4);
+    memcpy (dst + len - 4, &b, 4);
+  }
+  else if (len <= 16)
+  {
+    uint64_t a;
+    uint64_t b;
+
+    memcpy (&a, src, 8);
+    memcpy (&b, src + len - 8, 8);
+
+    memcpy (dst, &a, 8);
+    memcpy (dst + len - 8, &b, 8);
+  }
+  else
+  {
+    uint64_t a;
+    uint64_t b;
+    uint64_t c;
+    uint64_t d;
+
+    memcpy (&a, src, 8);
+    memcpy (&b, src + 8, 8);
+    memcpy (&c, src + len - 16, 8);
+    memcpy (&d, src + len - 8, 8);
+
+    memcpy (dst, &a, 8);
+    memcpy (dst + 8, &b, 8);
+    memcpy (dst + len - 16, &c, 8);
+    memcpy (dst + len - 8, &d, 8);
+  }
+}
+
+#define PP_COPY_KERNEL(N) \
+static void pp_copy_##N (uint8_t *dst, const uint8_t *src) { pp_copy_fixed (dst, src, N); }
+
+PP_COPY_KERNEL (1)  PP_COPY_KERNEL (2)  PP_COPY_KERNEL (3)  PP_COPY_KERNEL (4)
+PP_COPY_KERNEL (5)  PP_COPY_KERNEL (6)  PP_COPY_KERNEL (7)  PP_COPY_KERNEL (8)
+PP_COPY_KERNEL (9)  PP_COPY_KERNEL (10) PP_COPY_KERNEL (11) PP_COPY_KERNEL (12)
+PP_COPY_KERNEL (13) PP_COPY_KERNEL (14) PP_COPY_KERNEL (15) PP_COPY_KERNEL (16)
+PP_COPY_KERNEL (17) PP_COPY_KERNEL (18) PP_COPY_KERNEL (19) PP_COPY_KERNEL (20)
+PP_COPY_KERNEL (21) PP_COPY_KERNEL (22) PP_COPY_KERNEL (23) PP_COPY_KERNEL (24)
+PP_COPY_KERNEL (25) PP_COPY_KERNEL (26) PP_COPY_KERNEL (27) PP_COPY_KERNEL (28)
+PP_COPY_KERNEL (29) PP_COPY_KERNEL (30) PP_COPY_KERNEL (31) PP_COPY_KERNEL (32)
+
+static void pp_copy_0 (uint8_t *dst, const uint8_t *src)
+{
+  (void) dst;
+  (void) src;
+}
+
+static const pp_copy_fn pp_copy_tab[PP_COPY_LEN_MAX + 1] =
+{
+  pp_copy_0,
+  pp_copy_1,  pp_copy_2,  pp_copy_3,  pp_copy_4,  pp_copy_5,  pp_copy_6,  pp_copy_7,  pp_copy_8,
+  pp_copy_9,  pp_copy_10, pp_copy_11, pp_copy_12, pp_copy_13, pp_copy_14, pp_copy_15, pp_copy_16,
+  pp_copy_17, pp_copy_18, pp_copy_19, pp_copy_20, pp_copy_21, pp_copy_22, pp_copy_23, pp_copy_24,
+  pp_copy_25, pp_copy_26, pp_copy_27, pp_copy_28, pp_copy_29, pp_copy_30, pp_copy_31, pp_copy_32,
+};
+
+#endif
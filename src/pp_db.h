@@ -0,0 +1,151 @@
+#ifndef PP_DB_H
+#define PP_DB_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Element database written by --build-db and mapped by --db
+ *
+ * Layout of the file:
+ *
+ *   pp_db_hdr_t                                        one page
+ *   per length: cnt * stride bytes of elements         page aligned
+ *
+ * The elements of each length are stored the way pp keeps them in memory,
+ * back to back with a stride of at least their length, already deduped and
+ * in their final order. Every array is followed by at least PP_DB_PAD zero
+ * bytes, the vector kernels read that far past the last element, so pp
+ * uses the arrays in place from a read-only mapping.
+ *
+ * src_size and src_sum describe the wordlist the file was built from, the
+ * sum is pp_db_sum () over all of its bytes. The flags record how the
+ * wordlist was loaded, those options can not change afterwards. wl_max is
+ * the --wl-max of the build and wl_cnt the words it counted, of every
+ * length, a file is only used by runs that would load the same words.
+ * All integers are in host byte order, a file is only meant for machines
+ * of the same kind.
+ */
+
+#define PP_DB_MAGIC       0x42445050 /* "PPDB" */
+#define PP_DB_VERSION     1
+
+#define PP_DB_LEN_MAX     32
+#define PP_DB_PAD         32
+
+#define PP_DB_PAGE        4096
+
+#define PP_DB_DUPE_CHECK   (1u << 0)
+#define PP_DB_CASE_PERMUTE (1u << 1)
+#define PP_DB_SORTED       (1u << 2)
+
+typedef struct
+{
+  uint64_t off;
+  uint64_t cnt;
+  uint32_t stride;
+  uint32_t reserved;
+
+} pp_db_entry_t;
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t len_max;
+  uint32_t flags;
+
+  uint64_t size;
+  uint64_t wl_max;
+  uint64_t wl_cnt;
+  uint64_t src_size;
+  uint64_t src_sum;
+
+  pp_db_entry_t entries[PP_DB_LEN_MAX + 1];
+
+} pp_db_hdr_t;
+
+typedef struct
+{
+  uint64_t h;
+  uint64_t len;
+
+  uint8_t tail[8];
+  int     tail_len;
+
+} pp_db_sum_t;
+
+static inline uint64_t pp_db_align (const uint64_t off)
+{
+  return (off + PP_DB_PAGE - 1) & ~(uint64_t) (PP_DB_PAGE - 1);
+}
+
+static inline uint64_t pp_db_mum (const uint64_t a, const uint64_t b)
+{
+  const __uint128_t r = (__uint128_t) a * b;
+
+  return (uint64_t) r ^ (uint64_t) (r >> 64);
+}
+
+static inline uint64_t pp_db_sum_word (const uint64_t h, const uint8_t *buf)
+{
+  uint64_t w;
+
+  memcpy (&w, buf, 8);
+
+  return pp_db_mum (w ^ 0xe7037ed1a0b428dbull, h ^ 0x8ebc6af09c88c6e3ull);
+}
+
+static void pp_db_sum_init (pp_db_sum_t *sum)
+{
+  sum->h        = 0xa0761d6478bd642full;
+  sum->len      = 0;
+  sum->tail_len = 0;
+}
+
+static void pp_db_sum_update (pp_db_sum_t *sum, const uint8_t *buf, uint64_t len)
+{
+  // 8 byte words in stream order, so the sum does not depend on how the
+  // input was cut into blocks
+
+  sum->len += len;
+
+  if (sum->tail_len)
+  {
+    while (len && (sum->tail_len < 8))
+    {
+      sum->tail[sum->tail_len++] = *buf++;
+
+      len--;
+    }
+
+    if (sum->tail_len < 8) return;
+
+    sum->h = pp_db_sum_word (sum->h, sum->tail);
+
+    sum->tail_len = 0;
+  }
+
+  uint64_t h = sum->h;
+
+  for (; len >= 8; buf += 8, len -= 8) h = pp_db_sum_word (h, buf);
+
+  sum->h = h;
+
+  memcpy (sum->tail, buf, len);
+
+  sum->tail_len = (int) len;
+}
+
+static uint64_t pp_db_sum_final (const pp_db_sum_t *sum)
+{
+  uint8_t last[8] = { 0 };
+
+  memcpy (last, sum->tail, sum->tail_len);
+
+  const uint64_t h = pp_db_sum_word (sum->h, last);
+
+  return pp_db_mum (h ^ sum->len ^ 0x589965cc75374cc3ull, 0x1d8e4e27c47d124full);
+}
+
+#endif
@@ -0,0 +1,388 @@
+#ifndef PP_JIT_H
+#define PP_JIT_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Machine code run writers generated at runtime, x86-64 Linux only
+ *
+ * Within a run of a chain only the first element changes, so everything
+ * about a record is fixed: the element length and stride, the record length,
+ * where the element goes and the bytes around it. pp_jit_get () emits a loop
+ * for one such shape:
+ *
+ *   load the template bytes around the element into registers
+ *   loop:
+ *     copy the element with unrolled loads and stores of its exact length
+ *     store the template registers around it
+ *     store the terminator byte as an immediate
+ *     dst += rec_len, elems += elems_stride
+ *
+ * which is called once per run instead of going through the copy kernels
+ * record by record. Shapes are cached, chains of the same lengths share
+ * their loop. Shapes whose template does not fit in the registers get NULL,
+ * as do all other platforms, and the caller uses the C kernels instead.
+ *
+ * Generated code follows the System V calling convention and only touches
+ * caller saved registers: rdi dst, rsi template, rdx elements, rcx count.
+ */
+
+typedef void (*pp_jit_fn) (uint8_t *dst, const uint8_t *tmpl, const uint8_t *elems, uint64_t cnt);
+
+#define PP_JIT_TERM_NONE -1
+
+#if defined (__x86_64__) && defined (LINUX)
+
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define PP_JIT_CACHE_MAX 0x400
+#define PP_JIT_CODE_SIZE 0x1000
+
+#define PP_JIT_RAX 0
+#define PP_JIT_RCX 1
+#define PP_JIT_RDX 2
+#define PP_JIT_RSI 6
+#define PP_JIT_RDI 7
+#define PP_JIT_R8  8
+
+typedef struct
+{
+  int      elem_len;
+  uint64_t elems_stride;
+  int      rec_len;
+  int      rec_off;
+  int      term;
+
+  pp_jit_fn fn;
+
+} pp_jit_entry_t;
+
+typedef struct
+{
+  int off;
+  int width; /* 1, 2, 4, 8 or 16 for an xmm register */
+  int reg;
+
+} pp_jit_chunk_t;
+
+typedef struct
+{
+  uint8_t *buf;
+  int      len;
+
+} pp_jit_code_t;
+
+static pp_jit_entry_t pp_jit_cache[PP_JIT_CACHE_MAX];
+
+static int pp_jit_cache_cnt = 0;
+
+static pthread_mutex_t pp_jit_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static void pp_jit_byte (pp_jit_code_t *code, const int b)
+{
+  code->buf[code->len++] = (uint8_t) b;
+}
+
+static void pp_jit_u32 (pp_jit_code_t *code, const uint32_t v)
+{
+  memcpy (code->buf + code->len, &v, 4);
+
+  code->len += 4;
+}
+
+static void pp_jit_mov_mem (pp_jit_code_t *code, const int store, const int width, const int reg, const int base, const int32_t disp)
+{
+  // mov reg, [base + disp32] or mov [base + disp32], reg, base is never
+  // rsp/r12 or rbp/r13, so no SIB byte and mod 10 works for every base
+
+  const int rex_r = (reg >= 8) ? 0x04 : 0;
+
+  if (width == 16)
+  {
+    pp_jit_byte (code, 0xf3);
+
+    if (rex_r) pp_jit_byte (code, 0x40 | rex_r);
+
+    pp_jit_byte (code, 0x0f);
+    pp_jit_byte (code, (store) ? 0x7f : 0x6f);
+  }
+  else
+  {
+    if (width == 2) pp_jit_byte (code, 0x66);
+
+    const int rex_w = (width == 8) ? 0x08 : 0;
+
+    // byte access to sil needs a REX prefix, otherwise it means dh
+
+    const int rex_b8 = ((width == 1) && (reg >= 4)) ? 0x40 : 0;
+
+    if (rex_w || rex_r || rex_b8) pp_jit_byte (code, 0x40 | rex_w | rex_r);
+
+    if (width == 1) pp_jit_byte (code, (store) ? 0x88 : 0x8a);
+    else            pp_jit_byte (code, (store) ? 0x89 : 0x8b);
+  }
+
+  pp_jit_byte (code, 0x80 | ((reg & 7) << 3) | (base & 7));
+
+  pp_jit_u32 (code, (uint32_t) disp);
+}
+
+static void pp_jit_add_imm (pp_jit_code_t *code, const int reg, const uint32_t imm)
+{
+  // add reg, imm32
+
+  pp_jit_byte (code, 0x48);
+  pp_jit_byte (code, 0x81);
+  pp_jit_byte (code, 0xc0 | reg);
+
+  pp_jit_u32 (code, imm);
+}
+
+static int pp_jit_split (pp_jit_chunk_t *chunks, int chunks_cnt, const int beg, const int end, const int xmm_ok)
+{
+  // covers [beg, end) with as few loads as possible, the last one of a
+  // width overlaps the one before instead of falling back to smaller ones
+
+  const int len = end - beg;
+
+  if (len <= 0) return chunks_cnt;
+
+  int width = 1;
+
+  if      ((len >= 16) && xmm_ok) width = 16;
+  else if (len >= 8)              width = 8;
+  else if (len >= 4)              width = 4;
+  else if (len >= 2)              width = 2;
+
+  for (int off = beg; off < end; off += width)
+  {
+    pp_jit_chunk_t *chunk = &chunks[chunks_cnt++];
+
+    chunk->off   = (off + width > end) ? end - width : off;
+    chunk->width = width;
+    chunk->reg   = -1;
+  }
+
+  return chunks_cnt;
+}
+
+static pp_jit_fn pp_jit_compile (const int elem_len, const uint64_t elems_stride, const int rec_len, const int rec_off, const int term)
+{
+  if ((elems_stride > 0x7fffffff) || (rec_len > 0x7fffffff)) return NULL;
+
+  // the element is copied through rax
+
+  pp_jit_chunk_t elem_chunks[64];
+
+  const int elem_chunks_cnt = pp_jit_split (elem_chunks, 0, 0, elem_len, 0);
+
+  // the template around it is held in xmm0-15 and rsi, r8-r11
+
+  const int tmpl_end = (term == PP_JIT_TERM_NONE) ? rec_len : rec_len - 1;
+
+  pp_jit_chunk_t tmpl_chunks[64];
+
+  int tmpl_chunks_cnt = 0;
+
+  if (rec_len > 64 * 16) return NULL;
+
+  tmpl_chunks_cnt = pp_jit_split (tmpl_chunks, tmpl_chunks_cnt, 0, rec_off, 1);
+  tmpl_chunks_cnt = pp_jit_split (tmpl_chunks, tmpl_chunks_cnt, rec_off + elem_len, tmpl_end, 1);
+
+  static const int gprs[] = { PP_JIT_R8, PP_JIT_R8 + 1, PP_JIT_R8 + 2, PP_JIT_R8 + 3, PP_JIT_RSI };
+
+  int xmm_cnt = 0;
+  int gpr_cnt = 0;
+
+  for (int i = 0; i < tmpl_chunks_cnt; i++)
+  {
+    pp_jit_chunk_t *chunk = &tmpl_chunks[i];
+
+    if (chunk->width == 16)
+    {
+      if (xmm_cnt == 16) return NULL;
+
+      chunk->reg = xmm_cnt++;
+    }
+    else
+    {
+      if (gpr_cnt == 5) return NULL;
+
+      chunk->reg = gprs[gpr_cnt++];
+    }
+  }
+
+  uint8_t *buf = (uint8_t *) mmap (NULL, PP_JIT_CODE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (buf == MAP_FAILED) return NULL;
+
+  pp_jit_code_t code;
+
+  code.buf = buf;
+  code.len = 0;
+
+  // test rcx, rcx; jz done
+
+  pp_jit_byte (&code, 0x48); pp_jit_byte (&code, 0x85); pp_jit_byte (&code, 0xc9);
+
+  pp_jit_byte (&code, 0x0f); pp_jit_byte (&code, 0x84);
+
+  const int jz_pos = code.len;
+
+  pp_jit_u32 (&code, 0);
+
+  // rsi is the template pointer, it gets overwritten last
+
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (int i = 0; i < tmpl_chunks_cnt; i++)
+    {
+      const pp_jit_chunk_t *chunk = &tmpl_chunks[i];
+
+      if ((chunk->width != 16) && ((chunk->reg == PP_JIT_RSI) != pass)) continue;
+      if ((chunk->width == 16) && (pass == 1)) continue;
+
+      pp_jit_mov_mem (&code, 0, chunk->width, chunk->reg, PP_JIT_RSI, chunk->off);
+    }
+  }
+
+  const int loop_pos = code.len;
+
+  for (int i = 0; i < elem_chunks_cnt; i++)
+  {
+    const pp_jit_chunk_t *chunk = &elem_chunks[i];
+
+    pp_jit_mov_mem (&code, 0, chunk->width, PP_JIT_RAX, PP_JIT_RDX, chunk->off);
+    pp_jit_mov_mem (&code, 1, chunk->width, PP_JIT_RAX, PP_JIT_RDI, rec_off + chunk->off);
+  }
+
+  for (int i = 0; i < tmpl_chunks_cnt; i++)
+  {
+    const pp_jit_chunk_t *chunk = &tmpl_chunks[i];
+
+    pp_jit_mov_mem (&code, 1, chunk->width, chunk->reg, PP_JIT_RDI, chunk->off);
+  }
+
+  if (term != PP_JIT_TERM_NONE)
+  {
+    // mov byte [rdi + rec_len - 1], term
+
+    pp_jit_byte (&code, 0xc6);
+    pp_jit_byte (&code, 0x80 | PP_JIT_RDI);
+
+    pp_jit_u32 (&code, (uint32_t) (rec_len - 1));
+
+    pp_jit_byte (&code, term);
+  }
+
+  pp_jit_add_imm (&code, PP_JIT_RDI, (uint32_t) rec_len);
+  pp_jit_add_imm (&code, PP_JIT_RDX, (uint32_t) elems_stride);
+
+  // dec rcx; jnz loop
+
+  pp_jit_byte (&code, 0x48); pp_jit_byte (&code, 0xff); pp_jit_byte (&code, 0xc9);
+
+  pp_jit_byte (&code, 0x0f); pp_jit_byte (&code, 0x85);
+
+  pp_jit_u32 (&code, (uint32_t) (loop_pos - (code.len + 4)));
+
+  const uint32_t jz_rel = code.len - (jz_pos + 4);
+
+  memcpy (code.buf + jz_pos, &jz_rel, 4);
+
+  // ret
+
+  pp_jit_byte (&code, 0xc3);
+
+  if (mprotect (buf, PP_JIT_CODE_SIZE, PROT_READ | PROT_EXEC) == -1)
+  {
+    munmap (buf, PP_JIT_CODE_SIZE);
+
+    return NULL;
+  }
+
+  pp_jit_fn fn;
+
+  memcpy (&fn, &buf, sizeof (fn));
+
+  return fn;
+}
+
+static pp_jit_fn pp_jit_get (const int elem_len, const uint64_t elems_stride, const int rec_len, const int rec_off, const int term)
+{
+  pthread_mutex_lock (&pp_jit_mtx);
+
+  pp_jit_fn fn = NULL;
+
+  int found = 0;
+
+  for (int i = 0; i < pp_jit_cache_cnt; i++)
+  {
+    const pp_jit_entry_t *entry = &pp_jit_cache[i];
+
+    if (entry->elem_len     != elem_len)     continue;
+    if (entry->elems_stride != elems_stride) continue;
+    if (entry->rec_len      != rec_len)      continue;
+    if (entry->rec_off      != rec_off)      continue;
+    if (entry->term         != term)         continue;
+
+    fn = entry->fn;
+
+    found = 1;
+
+    break;
+  }
+
+  if ((found == 0) && (pp_jit_cache_cnt < PP_JIT_CACHE_MAX))
+  {
+    // failures are cached too, so a shape is only tried once
+
+    fn = pp_jit_compile (elem_len, elems_stride, rec_len, rec_off, term);
+
+    pp_jit_entry_t *entry = &pp_jit_cache[pp_jit_cache_cnt++];
+
+    entry->elem_len     = elem_len;
+    entry->elems_stride = elems_stride;
+    entry->rec_len      = rec_len;
+    entry->rec_off      = rec_off;
+    entry->term         = term;
+    entry->fn           = fn;
+  }
+
+  pthread_mutex_unlock (&pp_jit_mtx);
+
+  return fn;
+}
+
+static void pp_jit_free (void)
+{
+  for (int i = 0; i < pp_jit_cache_cnt; i++)
+  {
+    void *buf;
+
+    memcpy (&buf, &pp_jit_cache[i].fn, sizeof (buf));
+
+    if (buf) munmap (buf, PP_JIT_CODE_SIZE);
+  }
+
+  pp_jit_cache_cnt = 0;
+}
+
+#else
+
+static pp_jit_fn pp_jit_get (const int elem_len, const uint64_t elems_stride, const int rec_len, const int rec_off, const int term)
+{
+  (void) elem_len; (void) elems_stride; (void) rec_len; (void) rec_off; (void) term;
+
+  return NULL;
+}
+
+static void pp_jit_free (void)
+{
+}
+
+#endif
+
+#endif
@@ -0,0 +1,262 @@
+#ifndef PP_LZ_H
+#define PP_LZ_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Block compression used by --output-compress
+ *
+ * The output is a sequence of independent blocks, one per output buffer:
+ *
+ *   pp_lz_hdr_t                                        40 bytes
+ *   comp_len bytes                                     payload
+ *
+ * The payload holds raw_len bytes of records in the given --output-format,
+ * compressed with the codec below or stored as is if comp_len == raw_len.
+ * Every block starts at a record boundary, front coded records do not refer
+ * to the block before. pos is the keyspace position of the first candidate,
+ * so a reader can hop from header to header and start decoding at the block
+ * holding any position, or resume with -s at the end of a broken file.
+ *
+ * The codec is a plain LZ77 byte format in the spirit of LZ4: a token with
+ * the literal length in the high and the match length - 4 in the low nibble,
+ * nibbles of 15 continue in bytes of 255, then the literals, then a 16 bit
+ * little endian offset. The last sequence carries literals only.
+ */
+
+#define PP_LZ_MAGIC       0x5a4c5050 /* "PPLZ" */
+#define PP_LZ_VERSION     1
+
+#define PP_LZ_HASH_LOG    14
+#define PP_LZ_MIN_MATCH   4
+#define PP_LZ_LAST_LITS   5
+#define PP_LZ_OFFSET_MAX  0xffff
+
+typedef struct
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t format;
+  uint32_t raw_len;
+  uint32_t comp_len;
+  uint64_t cnt;
+  uint64_t pos[2];   /* low and high 64 bits */
+
+} pp_lz_hdr_t;
+
+static inline uint32_t pp_lz_read32 (const uint8_t *ptr)
+{
+  uint32_t v;
+
+  memcpy (&v, ptr, sizeof (v));
+
+  return v;
+}
+
+static inline uint32_t pp_lz_hash (const uint32_t v)
+{
+  return (v * 2654435761u) >> (32 - PP_LZ_HASH_LOG);
+}
+
+static inline uint8_t *pp_lz_put_len (uint8_t *op, uint32_t len)
+{
+  while (len >= 255)
+  {
+    *op++ = 255;
+
+    len -= 255;
+  }
+
+  *op++ = (uint8_t) len;
+
+  return op;
+}
+
+/* table needs (1 << PP_LZ_HASH_LOG) entries, returns 0 if dst_cap is too small */
+
+static inline int pp_lz_compress (const uint8_t *src, const int src_len, uint8_t *dst, const int dst_cap, uint32_t *table)
+{
+  const uint8_t *ip     = src;
+  const uint8_t *anchor = src;
+  const uint8_t *end    = src + src_len;
+
+  uint8_t *op     = dst;
+  uint8_t *op_end = dst + dst_cap;
+
+  memset (table, 0, sizeof (uint32_t) << PP_LZ_HASH_LOG);
+
+  if (src_len > PP_LZ_MIN_MATCH + PP_LZ_LAST_LITS)
+  {
+    const uint8_t *match_end = end - PP_LZ_LAST_LITS;
+    const uint8_t *ip_limit  = match_end - PP_LZ_MIN_MATCH;
+
+    ip++;
+
+    while (ip <= ip_limit)
+    {
+      const uint32_t seq = pp_lz_read32 (ip);
+
+      const uint32_t h = pp_lz_hash (seq);
+
+      const uint8_t *ref = src + table[h];
+
+      table[h] = (uint32_t) (ip - src);
+
+      if ((ip - ref > PP_LZ_OFFSET_MAX) || (pp_lz_read32 (ref) != seq))
+      {
+        // step faster through data that does not compress
+
+        ip += 1 + ((ip - anchor) >> 8);
+
+        continue;
+      }
+
+      while ((ip > anchor) && (ref > src) && (ip[-1] == ref[-1]))
+      {
+        ip--;
+        ref--;
+      }
+
+      const uint8_t *mp = ip  + PP_LZ_MIN_MATCH;
+      const uint8_t *mr = ref + PP_LZ_MIN_MATCH;
+
+      while ((mp < match_end) && (*mp == *mr))
+      {
+        mp++;
+        mr++;
+      }
+
+      const uint32_t lit_len   = (uint32_t) (ip - anchor);
+      const uint32_t match_len = (uint32_t) (mp - ip) - PP_LZ_MIN_MATCH;
+
+      if (op_end - op < (long) (1 + lit_len / 255 + 1 + lit_len + 2 + match_len / 255 + 1)) return 0;
+
+      uint8_t *token = op++;
+
+      *token = (uint8_t) ((((lit_len < 15) ? lit_len : 15) << 4) | ((match_len < 15) ? match_len : 15));
+
+      if (lit_len >= 15) op = pp_lz_put_len (op, lit_len - 15);
+
+      memcpy (op, anchor, lit_len);
+
+      op += lit_len;
+
+      const uint32_t off = (uint32_t) (ip - ref);
+
+      *op++ = (uint8_t) (off >> 0);
+      *op++ = (uint8_t) (off >> 8);
+
+      if (match_len >= 15) op = pp_lz_put_len (op, match_len - 15);
+
+      ip     = mp;
+      anchor = mp;
+
+      table[pp_lz_hash (pp_lz_read32 (ip - 2))] = (uint32_t) (ip - 2 - src);
+    }
+  }
+
+  const uint32_t lit_len = (uint32_t) (end - anchor);
+
+  if (op_end - op < (long) (1 + lit_len / 255 + 1 + lit_len)) return 0;
+
+  *op++ = (uint8_t) (((lit_len < 15) ? lit_len : 15) << 4);
+
+  if (lit_len >= 15) op = pp_lz_put_len (op, lit_len - 15);
+
+  memcpy (op, anchor, lit_len);
+
+  op += lit_len;
+
+  return (int) (op - dst);
+}
+
+/* returns the decompressed length, -1 on corrupt input */
+
+static inline int pp_lz_decompress (const uint8_t *src, const int src_len, uint8_t *dst, const int dst_cap)
+{
+  const uint8_t *ip     = src;
+  const uint8_t *ip_end = src + src_len;
+
+  uint8_t *op     = dst;
+  uint8_t *op_end = dst + dst_cap;
+
+  while (ip < ip_end)
+  {
+    const uint32_t token = *ip++;
+
+    size_t lit_len = token >> 4;
+
+    if (lit_len == 15)
+    {
+      uint32_t b;
+
+      do
+      {
+        if (ip == ip_end) return -1;
+
+        b = *ip++;
+
+        lit_len += b;
+
+      } while (b == 255);
+    }
+
+    if ((lit_len > (size_t) (ip_end - ip)) || (lit_len > (size_t) (op_end - op))) return -1;
+
+    memcpy (op, ip, lit_len);
+
+    op += lit_len;
+    ip += lit_len;
+
+    if (ip == ip_end) break;
+
+    if (ip_end - ip < 2) return -1;
+
+    const size_t off = ip[0] | (ip[1] << 8);
+
+    ip += 2;
+
+    if ((off == 0) || (off > (size_t) (op - dst))) return -1;
+
+    size_t match_len = token & 15;
+
+    if (match_len == 15)
+    {
+      uint32_t b;
+
+      do
+      {
+        if (ip == ip_end) return -1;
+
+        b = *ip++;
+
+        match_len += b;
+
+      } while (b == 255);
+    }
+
+    match_len += PP_LZ_MIN_MATCH;
+
+    if (match_len > (size_t) (op_end - op)) return -1;
+
+    const uint8_t *ref = op - off;
+
+    if (off >= match_len)
+    {
+      memcpy (op, ref, match_len);
+
+      op += match_len;
+    }
+    else
+    {
+      // overlapping copy repeats the last off bytes
+
+      while (match_len--) *op++ = *ref++;
+    }
+  }
+
+  return (int) (op - dst);
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef PP_SHM_H
+#define PP_SHM_H
+
+#include <stdint.h>
+
+/**
+ * Shared memory ring used by --output-shm
+ *
+ * Layout of the POSIX shared memory object:
+ *
+ *   pp_shm_hdr_t                                       one page
+ *   pp_shm_block_t[blocks_cnt]                         padded to a page
+ *   blocks_cnt * block_recs * sizeof (pw_t)            records
+ *
+ * There is a single producer (pp) and any number of consumers. Consumers
+ * claim whole blocks by incrementing claim, so every block is handed to
+ * exactly one consumer:
+ *
+ * - producer waits for free_seq == seq of the slot (seq % blocks_cnt),
+ *   fills it, sets cnt, then stores ready_seq = seq + 1 and head = seq + 1
+ * - consumer takes seq = claim++, waits for ready_seq == seq + 1 (or done
+ *   with head <= seq, which means end of stream), reads the records in
+ *   place and then stores free_seq = seq + blocks_cnt
+ *
+ * All sequence counters are updated with release stores and read with
+ * acquire loads. The producer publishes magic last, consumers must wait
+ * for it before touching anything else. The producer unlinks the object
+ * when it is done, so consumers have to attach while it is running.
+ *
+ * A producer that crashed leaves the object behind without done set. pid
+ * holds the process id of the producer, consumers treat the ring as stale
+ * once that process is gone, instead of waiting for blocks that never come.
+ * A new producer unlinks a stale object of the same name and starts over.
+ */
+
+#define PP_SHM_MAGIC      0x4d485350 /* "PSHM" */
+#define PP_SHM_VERSION    2
+
+#define PP_SHM_BLOCKS     64
+#define PP_SHM_BLOCK_RECS 4096
+
+#define PP_SHM_PAGE       4096
+
+/* Same layout as the password buffer in hashcat */
+
+typedef struct
+{
+  uint32_t i[64];
+  uint32_t pw_len;
+
+} pw_t;
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t blocks_cnt;
+  uint32_t block_recs;
+  uint32_t rec_size;
+  uint32_t done;
+  uint32_t pid;
+
+  uint64_t head  __attribute__ ((aligned (64)));
+  uint64_t claim __attribute__ ((aligned (64)));
+
+} pp_shm_hdr_t;
+
+typedef struct
+{
+  uint64_t ready_seq;
+  uint64_t free_seq;
+  uint32_t cnt;
+
+} __attribute__ ((aligned (64))) pp_shm_block_t;
+
+static inline uint64_t pp_shm_blocks_off (void)
+{
+  return PP_SHM_PAGE;
+}
+
+static inline uint64_t pp_shm_data_off (const uint32_t blocks_cnt)
+{
+  const uint64_t size = blocks_cnt * sizeof (pp_shm_block_t);
+
+  return pp_shm_blocks_off () + ((size + PP_SHM_PAGE - 1) & ~(uint64_t) (PP_SHM_PAGE - 1));
+}
+
+static inline uint64_t pp_shm_size (const uint32_t blocks_cnt, const uint32_t block_recs)
+{
+  return pp_shm_data_off (blocks_cnt) + (uint64_t) blocks_cnt * block_recs * sizeof (pw_t);
+}
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef PP_SIMD_H
+#define PP_SIMD_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Batch record writers for the runs of a chain where only the first
+ * element changes
+ *
+ * Record i of a run is the template record with the first elem_len bytes
+ * replaced by element i of the elements array. Each record is one vector
+ * store: the template is broadcast in a register once per run, element i
+ * is loaded unaligned and blended over it. The store may run past the end
+ * of the record into the next one, which gets written afterwards, but never
+ * past the end of the run. Loads read up to PP_SIMD_PAD bytes past the last
+ * element, the elements array must be allocated with that much slack.
+ *
+ * The functions return how many records they wrote, the caller writes the
+ * remaining ones at the end of the run. pp_simd_level () picks the widest
+ * variant the CPU supports at runtime.
+ *
+ * pp_simd_find_eol () is used by the wordlist loader, it returns the offset
+ * of the first newline or NUL byte, or len if there is none. It never reads
+ * past len, the tail shorter than a vector is scanned byte by byte.
+ */
+
+#define PP_SIMD_PAD 32
+
+#define PP_SIMD_NONE 0
+#define PP_SIMD_SSE2 1
+#define PP_SIMD_AVX2 2
+
+#if defined (__x86_64__) || defined (__i386__)
+
+#include <immintrin.h>
+
+static const uint8_t pp_simd_mask_tab[64] =
+{
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static int pp_simd_level (void)
+{
+  __builtin_cpu_init ();
+
+  if (__builtin_cpu_supports ("avx2")) return PP_SIMD_AVX2;
+  if (__builtin_cpu_supports ("sse2")) return PP_SIMD_SSE2;
+
+  return PP_SIMD_NONE;
+}
+
+__attribute__ ((target ("avx2")))
+static uint64_t pp_simd_run_avx2 (uint8_t *dst, const uint8_t *tmpl, const int rec_len, const uint8_t *elems, const uint64_t elems_stride, const int elem_len, const uint64_t cnt)
+{
+  if (elem_len > 32) return 0;
+
+  // the last records would store past the end of the run
+
+  const uint64_t tail = (rec_len < 32) ? (32 - 1) / rec_len : 0;
+
+  if (cnt <= tail) return 0;
+
+  const uint64_t vec_cnt = cnt - tail;
+
+  const __m256i mask = _mm256_loadu_si256 ((const __m256i *) (pp_simd_mask_tab + 32 - elem_len));
+
+  const __m256i rec_v = _mm256_loadu_si256 ((const __m256i *) tmpl);
+
+  if (rec_len <= 32)
+  {
+    for (uint64_t i = 0; i < vec_cnt; i++)
+    {
+      const __m256i elem_v = _mm256_loadu_si256 ((const __m256i *) (elems + i * elems_stride));
+
+      _mm256_storeu_si256 ((__m256i *) (dst + i * rec_len), _mm256_blendv_epi8 (rec_v, elem_v, mask));
+    }
+  }
+  else
+  {
+    for (uint64_t i = 0; i < vec_cnt; i++)
+    {
+      const __m256i elem_v = _mm256_loadu_si256 ((const __m256i *) (elems + i * elems_stride));
+
+      _mm256_storeu_si256 ((__m256i *) (dst + i * rec_len), _mm256_blendv_epi8 (rec_v, elem_v, mask));
+
+      memcpy (dst + i * rec_len + 32, tmpl + 32, rec_len - 32);
+    }
+  }
+
+  return vec_cnt;
+}
+
+__attribute__ ((target ("sse2")))
+static uint64_t pp_simd_run_sse2 (uint8_t *dst, const uint8_t *tmpl, const int rec_len, const uint8_t *elems, const uint64_t elems_stride, const int elem_len, const uint64_t cnt)
+{
+  if (elem_len > 16) return 0;
+
+  const uint64_t tail = (rec_len < 16) ? (16 - 1) / rec_len : 0;
+
+  if (cnt <= tail) return 0;
+
+  const uint64_t vec_cnt = cnt - tail;
+
+  const __m128i mask = _mm_loadu_si128 ((const __m128i *) (pp_simd_mask_tab + 32 - elem_len));
+
+  // no byte blend before SSE4.1, keep the template bytes outside of mask
+
+  const __m128i rec_v = _mm_andnot_si128 (mask, _mm_loadu_si128 ((const __m128i *) tmpl));
+
+  for (uint64_t i = 0; i < vec_cnt; i++)
+  {
+    const __m128i elem_v = _mm_and_si128 (mask, _mm_loadu_si128 ((const __m128i *) (elems + i * elems_stride)));
+
+    _mm_storeu_si128 ((__m128i *) (dst + i * rec_len), _mm_or_si128 (rec_v, elem_v));
+
+    if (rec_len > 16) memcpy (dst + i * rec_len + 16, tmpl + 16, rec_len - 16);
+  }
+
+  return vec_cnt;
+}
+
+__attribute__ ((target ("avx2")))
+static uint64_t pp_simd_find_eol_avx2 (const uint8_t *buf, const uint64_t len)
+{
+  const __m256i nl_v  = _mm256_set1_epi8 ('\n');
+  const __m256i nul_v = _mm256_setzero_si256 ();
+
+  uint64_t pos = 0;
+
+  for (; pos + 32 <= len; pos += 32)
+  {
+    const __m256i v = _mm256_loadu_si256 ((const __m256i *) (buf + pos));
+
+    const uint32_t mask = (uint32_t) _mm256_movemask_epi8 (_mm256_or_si256 (_mm256_cmpeq_epi8 (v, nl_v), _mm256_cmpeq_epi8 (v, nul_v)));
+
+    if (mask) return pos + __builtin_ctz (mask);
+  }
+
+  for (; pos < len; pos++)
+  {
+    if ((buf[pos] == '\n') || (buf[pos] == 0)) return pos;
+  }
+
+  return len;
+}
+
+__attribute__ ((target ("sse2")))
+static uint64_t pp_simd_find_eol_sse2 (const uint8_t *buf, const uint64_t len)
+{
+  const __m128i nl_v  = _mm_set1_epi8 ('\n');
+  const __m128i nul_v = _mm_setzero_si128 ();
+
+  uint64_t pos = 0;
+
+  for (; pos + 16 <= len; pos += 16)
+  {
+    const __m128i v = _mm_loadu_si128 ((const __m128i *) (buf + pos));
+
+    const uint32_t mask = (uint32_t) _mm_movemask_epi8 (_mm_or_si128 (_mm_cmpeq_epi8 (v, nl_v), _mm_cmpeq_epi8 (v, nul_v)));
+
+    if (mask) return pos + __builtin_ctz (mask);
+  }
+
+  for (; pos < len; pos++)
+  {
+    if ((buf[pos] == '\n') || (buf[pos] == 0)) return pos;
+  }
+
+  return len;
+}
+
+static uint64_t pp_simd_run (const int level, uint8_t *dst, const uint8_t *tmpl, const int rec_len, const uint8_t *elems, const uint64_t elems_stride, const int elem_len, const uint64_t cnt)
+{
+  if (level == PP_SIMD_AVX2) return pp_simd_run_avx2 (dst, tmpl, rec_len, elems, elems_stride, elem_len, cnt);
+  if (level == PP_SIMD_SSE2) return pp_simd_run_sse2 (dst, tmpl, rec_len, elems, elems_stride, elem_len, cnt);
+
+  return 0;
+}
+
+static uint64_t pp_simd_find_eol (const int level, const uint8_t *buf, const uint64_t len)
+{
+  if (level == PP_SIMD_AVX2) return pp_simd_find_eol_avx2 (buf, len);
+  if (level == PP_SIMD_SSE2) return pp_simd_find_eol_sse2 (buf, len);
+
+  for (uint64_t pos = 0; pos < len; pos++)
+  {
+    if ((buf[pos] == '\n') || (buf[pos] == 0)) return pos;
+  }
+
+  return len;
+}
+
+#else
+
+static int pp_simd_level (void)
+{
+  return PP_SIMD_NONE;
+}
+
+static uint64_t pp_simd_run (const int level, uint8_t *dst, const uint8_t *tmpl, const int rec_len, const uint8_t *elems, const uint64_t elems_stride, const int elem_len, const uint64_t cnt)
+{
+  (void) level; (void) dst; (void) tmpl; (void) rec_len; (void) elems; (void) elems_stride; (void) elem_len; (void) cnt;
+
+  return 0;
+}
+
+static uint64_t pp_simd_find_eol (const int level, const uint8_t *buf, const uint64_t len)
+{
+  (void) level;
+
+  for (uint64_t pos = 0; pos < len; pos++)
+  {
+    if ((buf[pos] == '\n') || (buf[pos] == 0)) return pos;
+  }
+
+  return len;
+}
+
+#endif
+
+#endif
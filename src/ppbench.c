@@ -0,0 +1,395 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pp_copy.h"
+#include "pp_jit.h"
+
+/**
+ * Name........: ppbench
+ * Description.: Compares the length specialized copy kernels of pp_copy.h
+ *               with memcpy() of a runtime length, per element length, and
+ *               the generated loops of pp_jit.h with the interpreted
+ *               chain_set_pwbuf_increment() walk, per chain shape
+ * License.....: MIT
+ */
+
+#define ELEMS_CNT 0x10000
+#define ROUNDS    0x400
+
+#define CHAIN_ELEMS_CNT 1000
+#define CHAIN_CANDS     50000000
+#define OUT_SIZE        0x100000
+#define REC_MAX         64
+
+typedef uint8_t  u8;
+typedef uint64_t u64;
+
+typedef struct
+{
+  const char *name;
+
+  int cnt;
+  int len[8];
+
+} shape_t;
+
+typedef struct
+{
+  int        cnt;
+  int        len[8];
+  u8        *elems[8];
+  pp_copy_fn copy[8];
+  u64        poses[8];
+
+} chain_t;
+
+static double now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void chain_init (chain_t *chain, const shape_t *shape, u8 *rec)
+{
+  // same elements for every shape, the output can be compared byte by byte
+
+  chain->cnt = shape->cnt;
+
+  int off = 0;
+
+  for (int idx = 0; idx < shape->cnt; idx++)
+  {
+    const int len = shape->len[idx];
+
+    chain->len[idx]   = len;
+    chain->elems[idx] = (u8 *) malloc ((size_t) CHAIN_ELEMS_CNT * len + 32);
+    chain->copy[idx]  = pp_copy_tab[len];
+    chain->poses[idx] = 0;
+
+    for (int i = 0; i < CHAIN_ELEMS_CNT * len; i++) chain->elems[idx][i] = 'a' + ((i * 7 + idx) % 26);
+
+    memcpy (rec + off, chain->elems[idx], len);
+
+    off += len;
+  }
+
+  rec[off] = '\n';
+}
+
+static void chain_increment (chain_t *chain, u8 *pw_buf)
+{
+  // chain_set_pwbuf_increment () of pp.c
+
+  for (int idx = 0; idx < chain->cnt; idx++)
+  {
+    chain->poses[idx]++;
+
+    if (chain->poses[idx] < CHAIN_ELEMS_CNT)
+    {
+      chain->copy[idx] (pw_buf, chain->elems[idx] + chain->poses[idx] * chain->len[idx]);
+
+      break;
+    }
+
+    chain->poses[idx] = 0;
+
+    chain->copy[idx] (pw_buf, chain->elems[idx]);
+
+    pw_buf += chain->len[idx];
+  }
+}
+
+static u64 run_interp (chain_t *chain, u8 *rec, const int rec_len, u8 *out, u64 cnt)
+{
+  // one candidate at a time: copy the record out, step the chain
+
+  u64 sum = 0;
+
+  u8 *dst = out;
+
+  while (cnt--)
+  {
+    if (dst + rec_len > out + OUT_SIZE)
+    {
+      sum += out[0];
+
+      dst = out;
+    }
+
+    memcpy (dst, rec, rec_len);
+
+    dst += rec_len;
+
+    chain_increment (chain, rec);
+  }
+
+  return sum + out[0];
+}
+
+static u64 run_jit (chain_t *chain, pp_jit_fn fn, u8 *rec, const int rec_len, u8 *out, u64 cnt)
+{
+  // whole runs of the first element per call, the other elements step in
+  // between like in chain_emit_recs () of pp.c
+
+  u64 sum = 0;
+
+  u8 *dst = out;
+
+  while (cnt)
+  {
+    u64 run_cnt = CHAIN_ELEMS_CNT - chain->poses[0];
+
+    if (run_cnt > cnt) run_cnt = cnt;
+
+    const u64 fit = (out + OUT_SIZE - dst) / rec_len;
+
+    if (fit == 0)
+    {
+      sum += out[0];
+
+      dst = out;
+
+      continue;
+    }
+
+    if (run_cnt > fit) run_cnt = fit;
+
+    fn (dst, rec, chain->elems[0] + chain->poses[0] * chain->len[0], run_cnt);
+
+    dst += run_cnt * rec_len;
+    cnt -= run_cnt;
+
+    chain->poses[0] += run_cnt - 1;
+
+    chain_increment (chain, rec);
+  }
+
+  return sum + out[0];
+}
+
+static int jit_check (void)
+{
+  // every element length, record length and framing pp uses against a
+  // plain memcpy() of the template and the element
+
+  const int terms[3] = { '\n', 0, PP_JIT_TERM_NONE };
+
+  u8 elems[4 * 32 + 32];
+  u8 tmpl[REC_MAX];
+  u8 want[REC_MAX * 4 + 16];
+  u8 got[REC_MAX * 4 + 16];
+
+  for (int i = 0; i < (int) sizeof (elems); i++) elems[i] = 'A' + (i % 53);
+  for (int i = 0; i < (int) sizeof (tmpl);  i++) tmpl[i]  = 'a' + (i % 26);
+
+  int checked = 0;
+
+  for (int elem_len = 1; elem_len <= 32; elem_len++)
+  {
+    for (int rec_off = 0; rec_off <= 1; rec_off++)
+    {
+      for (int rec_len = rec_off + elem_len + 1; rec_len <= REC_MAX; rec_len++)
+      {
+        for (int t = 0; t < 3; t++)
+        {
+          const pp_jit_fn fn = pp_jit_get (elem_len, 32, rec_len, rec_off, terms[t]);
+
+          if (fn == NULL) continue;
+
+          memset (want, 0xee, sizeof (want));
+          memset (got,  0xee, sizeof (got));
+
+          for (int i = 0; i < 4; i++)
+          {
+            memcpy (want + i * rec_len, tmpl, rec_len);
+            memcpy (want + i * rec_len + rec_off, elems + i * 32, elem_len);
+
+            if (terms[t] != PP_JIT_TERM_NONE) want[i * rec_len + rec_len - 1] = (u8) terms[t];
+          }
+
+          fn (got, tmpl, elems, 4);
+
+          // more shapes than pp ever needs at once, keep the cache small
+
+          pp_jit_free ();
+
+          if (memcmp (want, got, sizeof (want)) != 0)
+          {
+            fprintf (stderr, "JIT mismatch: elem_len %d rec_len %d rec_off %d term %d\n", elem_len, rec_len, rec_off, terms[t]);
+
+            return (-1);
+          }
+
+          checked++;
+        }
+      }
+    }
+  }
+
+  return checked;
+}
+
+int main (int argc, char *argv[])
+{
+  const int rounds = (argc > 1) ? atoi (argv[1]) : ROUNDS;
+
+  // same access pattern as chain_set_pwbuf_increment (): elements stored
+  // back to back, each one copied to the same place in the candidate
+
+  u8 *elems = (u8 *) malloc ((size_t) ELEMS_CNT * PP_COPY_LEN_MAX);
+
+  for (size_t i = 0; i < (size_t) ELEMS_CNT * PP_COPY_LEN_MAX; i++) elems[i] = 'a' + (i % 26);
+
+  u8 pw_buf[PP_COPY_LEN_MAX * 2];
+
+  memset (pw_buf, 0, sizeof (pw_buf));
+
+  // the length must not be a constant the compiler can see through
+
+  volatile int len_opaque;
+
+  u64 sum = 0;
+
+  printf ("len   memcpy ns   kernel ns   speedup\n");
+
+  for (int len = 1; len <= PP_COPY_LEN_MAX; len++)
+  {
+    len_opaque = len;
+
+    const int len_rt = len_opaque;
+
+    const pp_copy_fn copy = pp_copy_tab[len];
+
+    double t0 = now ();
+
+    for (int r = 0; r < rounds; r++)
+    {
+      for (int i = 0; i < ELEMS_CNT; i++)
+      {
+        memcpy (pw_buf, elems + (size_t) i * len_rt, len_rt);
+
+        __asm__ __volatile__ ("" : : "r" (pw_buf) : "memory");
+      }
+    }
+
+    double t1 = now ();
+
+    for (int r = 0; r < rounds; r++)
+    {
+      for (int i = 0; i < ELEMS_CNT; i++)
+      {
+        copy (pw_buf, elems + (size_t) i * len);
+
+        __asm__ __volatile__ ("" : : "r" (pw_buf) : "memory");
+      }
+    }
+
+    double t2 = now ();
+
+    sum += pw_buf[0];
+
+    const double copies = (double) rounds * ELEMS_CNT;
+
+    const double ns_memcpy = (t1 - t0) / copies * 1e9;
+    const double ns_kernel = (t2 - t1) / copies * 1e9;
+
+    printf ("%3d   %9.3f   %9.3f   %6.2fx\n", len, ns_memcpy, ns_kernel, ns_memcpy / ns_kernel);
+  }
+
+  free (elems);
+
+  // generated run loops against the interpreted walk
+
+  const int checked = jit_check ();
+
+  if (checked == -1) return (-1);
+
+  if (checked == 0)
+  {
+    printf ("\nno JIT on this platform\n");
+
+    return (sum == 0);
+  }
+
+  printf ("\n%d JIT shapes checked\n\n", checked);
+
+  static const shape_t shapes[] =
+  {
+    { "short 4+4",         2, { 4, 4 } },
+    { "short 8+8",         2, { 8, 8 } },
+    { "long 8x3",          8, { 3, 3, 3, 3, 3, 3, 3, 3 } },
+    { "long 8x4",          8, { 4, 4, 4, 4, 4, 4, 4, 4 } },
+  };
+
+  u8 *out_interp = (u8 *) calloc (OUT_SIZE, 1);
+  u8 *out_jit    = (u8 *) calloc (OUT_SIZE, 1);
+
+  printf ("chain        interp ns   jit ns   speedup\n");
+
+  for (int s = 0; s < (int) (sizeof (shapes) / sizeof (shapes[0])); s++)
+  {
+    const shape_t *shape = &shapes[s];
+
+    int rec_len = 1;
+
+    for (int idx = 0; idx < shape->cnt; idx++) rec_len += shape->len[idx];
+
+    const pp_jit_fn fn = pp_jit_get (shape->len[0], shape->len[0], rec_len, 0, '\n');
+
+    if (fn == NULL) continue;
+
+    u8 rec_interp[REC_MAX];
+    u8 rec_jit[REC_MAX];
+
+    chain_t chain_interp;
+    chain_t chain_jit;
+
+    chain_init (&chain_interp, shape, rec_interp);
+    chain_init (&chain_jit,    shape, rec_jit);
+
+    const u64 cands = (u64) CHAIN_CANDS * rounds / ROUNDS;
+
+    double t0 = now ();
+
+    sum += run_interp (&chain_interp, rec_interp, rec_len, out_interp, cands);
+
+    double t1 = now ();
+
+    sum += run_jit (&chain_jit, fn, rec_jit, rec_len, out_jit, cands);
+
+    double t2 = now ();
+
+    if (memcmp (out_interp, out_jit, OUT_SIZE) != 0)
+    {
+      fprintf (stderr, "JIT output differs for %s\n", shape->name);
+
+      return (-1);
+    }
+
+    const double ns_interp = (t1 - t0) / cands * 1e9;
+    const double ns_jit    = (t2 - t1) / cands * 1e9;
+
+    printf ("%-10s   %9.3f   %6.3f   %6.2fx\n", shape->name, ns_interp, ns_jit, ns_interp / ns_jit);
+
+    for (int idx = 0; idx < shape->cnt; idx++)
+    {
+      free (chain_interp.elems[idx]);
+      free (chain_jit.elems[idx]);
+    }
+  }
+
+  free (out_interp);
+  free (out_jit);
+
+  pp_jit_free ();
+
+  return (sum == 0);
+}
@@ -0,0 +1,151 @@
+#!/bin/sh
+
+##
+## Regression checks for the pre-sized output modes and the loaders
+##
+## --output-mmap sizes its files from the number of candidates of each
+## length, which has to follow the main loop exactly, also when a length
+## runs out of keyspace partway through one. The list below has 400 words
+## of 3 letters, with --pw-max=6 length 3 is done long before the others.
+## Every mode is compared with plain stdout output of the same run.
+##
+## Every way of loading a wordlist has to give the elements the original
+## fgets () loader gave, in the same order.
+##
+## Usage: ./ppcheck.sh [./pp64.bin]
+##
+
+PP=${1:-./pp64.bin}
+
+TMP=$(mktemp -d) || exit 1
+
+trap 'rm -rf "$TMP"' EXIT
+
+fails=0
+
+# a wrong size used to end in a crash or an endless loop
+
+pp ()
+{
+  if command -v timeout > /dev/null
+  then
+    timeout 60 "$PP" "$@"
+  else
+    "$PP" "$@"
+  fi
+}
+
+fail ()
+{
+  echo "FAIL: $*"
+
+  fails=$((fails + 1))
+}
+
+awk 'BEGIN { a = "abcdefghijklmnopqrstuvwxyz"; n = 0; for (i = 1; i <= 26; i++) for (j = 1; j <= 26; j++) for (k = 1; k <= 26; k++) if (n++ < 400) print substr (a, i, 1) substr (a, j, 1) substr (a, k, 1) }' > "$TMP/wl.txt"
+
+for range in "--pw-max=6" "--pw-min=3 --pw-max=7" "--pw-max=6 -s 1000" "--pw-max=6 -s 1121 -l 100000" "--pw-max=6 -s 400 -l 160000"
+do
+  pp $range "$TMP/wl.txt" > "$TMP/ref" || { fail "$range"; continue; }
+
+  rm -f "$TMP/out"
+
+  pp $range --output-mmap -o "$TMP/out" "$TMP/wl.txt" && cmp -s "$TMP/ref" "$TMP/out" || fail "$range --output-mmap"
+
+  pp $range --output-blocks=7 "$TMP/wl.txt" > "$TMP/ref_blocks"
+
+  rm -f "$TMP/out"
+
+  pp $range --output-blocks=7 --output-mmap -o "$TMP/out" "$TMP/wl.txt" && cmp -s "$TMP/ref_blocks" "$TMP/out" || fail "$range --output-blocks --output-mmap"
+
+  rm -rf "$TMP/split" "$TMP/split_mmap"
+
+  mkdir "$TMP/split" "$TMP/split_mmap"
+
+  pp $range --output-split-len="$TMP/split" "$TMP/wl.txt" || fail "$range --output-split-len"
+
+  pp $range --output-split-len="$TMP/split_mmap" --output-mmap "$TMP/wl.txt" && diff -r "$TMP/split" "$TMP/split_mmap" > /dev/null || fail "$range --output-split-len --output-mmap"
+done
+
+# CRLF line ends, dupes, NUL bytes, a line longer than BUFSIZ whose last
+# piece is a word of its own, words too long for an element and no line
+# end at the end
+
+awk 'BEGIN { a = "abcdefghijklmnopqrstuvwxyz"; for (i = 0; i < 300; i++) { w = substr (a, i % 26 + 1, 1) substr (a, int (i / 26) + 1, 1) substr ("xyz", 1, i % 4); printf "%s%s\n", w, (i % 3 == 0) ? "\r" : ""; if (i % 5 == 0) print w } l = ""; for (i = 0; i < 8194; i++) l = l substr (a, i % 26 + 1, 1); print l; print "longerthananyelementofthewordlistcanbe" }' > "$TMP/in.txt"
+
+printf 'ab\000cd\nx\000\r\n\000\nlast' >> "$TMP/in.txt"
+
+# the output of the fgets () loader for this list, with glibc's BUFSIZ
+
+LOAD_SUM="4248322012 210154"
+
+pp --pw-max=5 "$TMP/in.txt" > "$TMP/ref_in" || fail "loader"
+
+[ "$(cksum < "$TMP/ref_in")" = "$LOAD_SUM" ] || fail "loader differs from the fgets () loader"
+
+check_load ()
+{
+  # a file is mapped, a pipe is read in blocks
+
+  name=$1; shift
+
+  pp "$@" --pw-max=5 "$TMP/in.txt" > "$TMP/out" && cmp -s "$TMP/ref_in" "$TMP/out" || fail "$name, file"
+
+  cat "$TMP/in.txt" | pp "$@" --pw-max=5 > "$TMP/out" && cmp -s "$TMP/ref_in" "$TMP/out" || fail "$name, pipe"
+}
+
+check_load "loader"
+
+check_load "--load-threads=3" --load-threads=3
+
+# 12000 different words of 4 letters, a quarter of the lines are dupes, the
+# dupes table has to grow a few times. With single elements of one length
+# the output is the deduped wordlist itself
+
+awk 'BEGIN { a = "abcdefghijklmnopqrstuvwxyz"; for (r = 0; r < 2; r++) for (i = 0; i < 8000; i++) print substr (a, i % 26 + 1, 1) substr (a, int (i / 26) % 26 + 1, 1) substr (a, int (i / 676) + 1, 1) substr (a, i % 2 * r * 3 + 1, 1) }' > "$TMP/dupes.txt"
+
+awk '!seen[$0]++' "$TMP/dupes.txt" > "$TMP/ref_dupes"
+
+check_dupes ()
+{
+  name=$1; shift
+
+  pp "$@" --pw-min=4 --pw-max=4 --elem-cnt-max=1 "$TMP/dupes.txt" > "$TMP/out" && cmp -s "$TMP/ref_dupes" "$TMP/out" || fail "$name, dupes"
+}
+
+check_dupes "dupes check"
+
+check_load  "--dupe-mode=sort-keep-order" --dupe-mode=sort-keep-order
+check_dupes "--dupe-mode=sort-keep-order" --dupe-mode=sort-keep-order
+
+check_load  "--dupe-mode=sort-keep-order --load-threads=3" --dupe-mode=sort-keep-order --load-threads=3
+check_dupes "--dupe-mode=sort-keep-order --load-threads=3" --dupe-mode=sort-keep-order --load-threads=3
+
+# a database has to give the elements of the run it replaces
+
+rm -f "$TMP/in.ppdb" "$TMP/pipe.ppdb" "$TMP/dupes.ppdb"
+
+pp --build-db="$TMP/in.ppdb" "$TMP/in.txt" || fail "--build-db"
+
+cat "$TMP/in.txt" | pp --build-db="$TMP/pipe.ppdb" || fail "--build-db, pipe"
+
+pp --build-db="$TMP/dupes.ppdb" "$TMP/dupes.txt" || fail "--build-db, dupes"
+
+pp --db="$TMP/in.ppdb" --pw-max=5 > "$TMP/out" && cmp -s "$TMP/ref_in" "$TMP/out" || fail "--db"
+
+pp --db="$TMP/pipe.ppdb" --pw-max=5 > "$TMP/out" && cmp -s "$TMP/ref_in" "$TMP/out" || fail "--db, built from a pipe"
+
+pp --db="$TMP/in.ppdb" --pw-max=5 "$TMP/in.txt" > "$TMP/out" && cmp -s "$TMP/ref_in" "$TMP/out" || fail "--db with its wordlist"
+
+pp --db="$TMP/dupes.ppdb" --pw-min=4 --pw-max=4 --elem-cnt-max=1 > "$TMP/out" && cmp -s "$TMP/ref_dupes" "$TMP/out" || fail "--db, dupes"
+
+pp --db="$TMP/in.ppdb" --pw-max=5 "$TMP/dupes.txt" > /dev/null 2>&1 && fail "--db with another wordlist"
+
+if [ $fails -ne 0 ]
+then
+  echo "$fails checks failed"
+
+  exit 1
+fi
+
+echo "All checks passed"
@@ -0,0 +1,451 @@
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+
+#ifdef WINDOWS
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "pp_lz.h"
+
+/**
+ * Name........: ppdecode
+ * Description.: Decoder for the front coded (--output-format=front) and the
+ *               compressed (--output-compress) output of pp
+ * License.....: MIT
+ */
+
+#define PW_LEN_MAX  32
+#define RAW_LEN_MAX 0x4000000
+
+#define FORMAT_FRONT 5 /* OUT_FORMAT_FRONT in pp.c */
+
+typedef uint8_t  u8;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef struct
+{
+  u8  prev[PW_LEN_MAX];
+  int prev_len;
+
+  u64 recs;
+
+} front_t;
+
+static const char *USAGE[] =
+{
+  "Usage: %s [options] [FILE]",
+  "",
+  "Reads FILE or stdin and prints the candidates, front coded records newline terminated",
+  "",
+  "  -l,  --list                List the blocks of a compressed file",
+  "  -s,  --skip=NUM            Start at the compressed block holding keyspace position NUM",
+  "  -h,  --help                Print help",
+  "",
+  NULL
+};
+
+static void usage_print (const char *progname)
+{
+  for (int i = 0; USAGE[i] != NULL; i++)
+  {
+    printf (USAGE[i], progname);
+
+    putchar ('\n');
+  }
+}
+
+static u8  out_buf[BUFSIZ * 16];
+static int out_len = 0;
+
+static void out_flush (void)
+{
+  if (out_len) fwrite (out_buf, 1, out_len, stdout);
+
+  out_len = 0;
+}
+
+static void out_write (const u8 *buf, int len)
+{
+  if (out_len + len > (int) sizeof (out_buf)) out_flush ();
+
+  if (len > (int) sizeof (out_buf))
+  {
+    fwrite (buf, 1, len, stdout);
+
+    return;
+  }
+
+  memcpy (out_buf + out_len, buf, len);
+
+  out_len += len;
+}
+
+static int front_decode (front_t *front, const u8 *buf, const int len, const char *name)
+{
+  // see out_push_front() in pp.c for the record layout, returns the number
+  // of bytes of complete records decoded
+
+  const u8 *ptr = buf;
+  const u8 *end = buf + len;
+
+  while (ptr < end)
+  {
+    int pw_len;
+    int pre;
+    int suf;
+    int mid;
+
+    int hdr_len;
+
+    if (ptr[0] != 0xff)
+    {
+      pw_len = front->prev_len;
+      pre    = ptr[0] >> 4;
+      mid    = ptr[0] & 15;
+      suf    = pw_len - pre - mid;
+
+      hdr_len = 1;
+    }
+    else
+    {
+      if (end - ptr < 4) break;
+
+      pw_len = ptr[1];
+      pre    = ptr[2];
+      suf    = ptr[3];
+      mid    = pw_len - pre - suf;
+
+      hdr_len = 4;
+    }
+
+    if ((pw_len == 0) || (pw_len > PW_LEN_MAX) || (mid < 0) || (suf < 0) || (pre + suf > front->prev_len))
+    {
+      fprintf (stderr, "%s: invalid record %llu\n", name, (unsigned long long) front->recs);
+
+      return (-1);
+    }
+
+    if (end - ptr < hdr_len + mid) break;
+
+    ptr += hdr_len;
+
+    // suffix first, it may overlap with where the new bytes go
+
+    memmove (front->prev + pre + mid, front->prev + front->prev_len - suf, suf);
+
+    memcpy (front->prev + pre, ptr, mid);
+
+    front->prev_len = pw_len;
+
+    if (out_len + pw_len + 1 > (int) sizeof (out_buf)) out_flush ();
+
+    memcpy (out_buf + out_len, front->prev, pw_len);
+
+    out_len += pw_len;
+
+    out_buf[out_len++] = '\n';
+
+    ptr += mid;
+
+    front->recs++;
+  }
+
+  return ptr - buf;
+}
+
+static int decode_front (FILE *fp, u8 *in_buf, int in_len, const int in_size, const char *name)
+{
+  front_t front;
+
+  front.prev_len = 0;
+  front.recs     = 0;
+
+  while (1)
+  {
+    const int nread = fread (in_buf + in_len, 1, in_size - in_len, fp);
+
+    in_len += nread;
+
+    const int done = front_decode (&front, in_buf, in_len, name);
+
+    if (done == -1) return (-1);
+
+    memmove (in_buf, in_buf + done, in_len - done);
+
+    in_len -= done;
+
+    if (nread == 0) break;
+  }
+
+  out_flush ();
+
+  if (ferror (fp))
+  {
+    fprintf (stderr, "%s: %s\n", name, strerror (errno));
+
+    return (-1);
+  }
+
+  if (in_len)
+  {
+    fprintf (stderr, "%s: truncated after record %llu\n", name, (unsigned long long) front.recs);
+
+    return (-1);
+  }
+
+  return 0;
+}
+
+static int skip_bytes (FILE *fp, u64 len)
+{
+  // pipes cannot seek
+
+  if (fseeko (fp, len, SEEK_CUR) == 0) return 0;
+
+  u8 buf[BUFSIZ];
+
+  while (len)
+  {
+    const size_t n = fread (buf, 1, (len < sizeof (buf)) ? len : sizeof (buf), fp);
+
+    if (n == 0) return (-1);
+
+    len -= n;
+  }
+
+  return 0;
+}
+
+static int decode_lz (FILE *fp, const u8 *in_buf, const int in_len, const int list, const u64 skip, const char *name)
+{
+  u8 *comp_buf = (u8 *) malloc (RAW_LEN_MAX);
+  u8 *raw_buf  = (u8 *) malloc (RAW_LEN_MAX);
+
+  if ((comp_buf == NULL) || (raw_buf == NULL))
+  {
+    fprintf (stderr, "Out of memory\n");
+
+    return (-1);
+  }
+
+  int rc = 0;
+
+  int started = 0;
+
+  u64 off = 0;
+
+  // the caller already read the start of the first header
+
+  size_t pre_len = in_len;
+
+  while (1)
+  {
+    pp_lz_hdr_t hdr;
+
+    memcpy (&hdr, in_buf, pre_len);
+
+    const size_t got = pre_len + fread ((u8 *) &hdr + pre_len, 1, sizeof (hdr) - pre_len, fp);
+
+    pre_len = 0;
+
+    if (got == 0) break;
+
+    if ((got != sizeof (hdr)) || (hdr.magic != PP_LZ_MAGIC) || (hdr.version != PP_LZ_VERSION)
+     || (hdr.raw_len > RAW_LEN_MAX) || (hdr.comp_len > hdr.raw_len))
+    {
+      fprintf (stderr, "%s: invalid block header at offset %llu\n", name, (unsigned long long) off);
+
+      rc = -1;
+
+      break;
+    }
+
+    // blocks wholly before skip are stepped over without reading them
+
+    const int before = (hdr.pos[1] == 0) && (hdr.pos[0] + hdr.cnt <= skip);
+
+    if (list || before)
+    {
+      if (list)
+      {
+        printf ("offset %llu pos %llu cnt %llu raw %u comp %u format %u\n", (unsigned long long) off,
+          (unsigned long long) hdr.pos[0], (unsigned long long) hdr.cnt, hdr.raw_len, hdr.comp_len, hdr.format);
+      }
+
+      if (skip_bytes (fp, hdr.comp_len) == -1)
+      {
+        fprintf (stderr, "%s: truncated block at offset %llu\n", name, (unsigned long long) off);
+
+        rc = -1;
+
+        break;
+      }
+
+      off += sizeof (hdr) + hdr.comp_len;
+
+      continue;
+    }
+
+    if ((started == 0) && skip)
+    {
+      fprintf (stderr, "Starting at keyspace position %llu\n", (unsigned long long) hdr.pos[0]);
+    }
+
+    started = 1;
+
+    if (fread (comp_buf, 1, hdr.comp_len, fp) != hdr.comp_len)
+    {
+      fprintf (stderr, "%s: truncated block at offset %llu\n", name, (unsigned long long) off);
+
+      rc = -1;
+
+      break;
+    }
+
+    const u8 *raw = comp_buf;
+
+    if (hdr.comp_len < hdr.raw_len)
+    {
+      if (pp_lz_decompress (comp_buf, hdr.comp_len, raw_buf, hdr.raw_len) != (int) hdr.raw_len)
+      {
+        fprintf (stderr, "%s: corrupt block at offset %llu\n", name, (unsigned long long) off);
+
+        rc = -1;
+
+        break;
+      }
+
+      raw = raw_buf;
+    }
+
+    if (hdr.format == FORMAT_FRONT)
+    {
+      front_t front;
+
+      front.prev_len = 0;
+      front.recs     = 0;
+
+      if (front_decode (&front, raw, hdr.raw_len, name) != (int) hdr.raw_len)
+      {
+        fprintf (stderr, "%s: corrupt block at offset %llu\n", name, (unsigned long long) off);
+
+        rc = -1;
+
+        break;
+      }
+    }
+    else
+    {
+      out_write (raw, hdr.raw_len);
+    }
+
+    off += sizeof (hdr) + hdr.comp_len;
+  }
+
+  out_flush ();
+
+  free (comp_buf);
+  free (raw_buf);
+
+  return rc;
+}
+
+int main (int argc, char *argv[])
+{
+  int list = 0;
+  u64 skip = 0;
+
+  struct option long_options[] =
+  {
+    {"list", no_argument,       0, 'l'},
+    {"skip", required_argument, 0, 's'},
+    {"help", no_argument,       0, 'h'},
+    {0, 0, 0, 0}
+  };
+
+  int option_index = 0;
+
+  int c;
+
+  while ((c = getopt_long (argc, argv, "ls:h", long_options, &option_index)) != -1)
+  {
+    switch (c)
+    {
+      case 'l': list = 1;                             break;
+      case 's': skip = strtoull (optarg, NULL, 10);   break;
+      case 'h': usage_print (argv[0]);                return (-1);
+
+      default: return (-1);
+    }
+  }
+
+  if (optind + 1 < argc)
+  {
+    usage_print (argv[0]);
+
+    return (-1);
+  }
+
+  #ifdef WINDOWS
+  setmode (fileno (stdin),  O_BINARY);
+  setmode (fileno (stdout), O_BINARY);
+  #endif
+
+  FILE *fp = stdin;
+
+  const char *name = "stdin";
+
+  if (optind < argc)
+  {
+    name = argv[optind];
+
+    fp = fopen (name, "rb");
+
+    if (fp == NULL)
+    {
+      fprintf (stderr, "%s: %s\n", name, strerror (errno));
+
+      return (-1);
+    }
+  }
+
+  // the first bytes tell the compressed stream from plain front coding
+
+  static u8 in_buf[BUFSIZ * 16];
+
+  int in_len = fread (in_buf, 1, sizeof (u32), fp);
+
+  u32 magic = 0;
+
+  if (in_len == sizeof (u32)) memcpy (&magic, in_buf, sizeof (u32));
+
+  int rc;
+
+  if (magic == PP_LZ_MAGIC)
+  {
+    rc = decode_lz (fp, in_buf, in_len, list, skip, name);
+  }
+  else if (list || skip)
+  {
+    fprintf (stderr, "%s: options --list and --skip require a compressed file\n", name);
+
+    rc = -1;
+  }
+  else
+  {
+    rc = decode_front (fp, in_buf, in_len, sizeof (in_buf), name);
+  }
+
+  if (fp != stdin) fclose (fp);
+
+  return rc;
+}
@@ -0,0 +1,346 @@
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sched.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "pp_shm.h"
+
+/**
+ * Name........: ppshm
+ * Description.: Reference consumer for the shared memory ring of pp --output-shm
+ * License.....: MIT
+ */
+
+#define CONSUMERS_MAX 64
+
+typedef uint8_t  u8;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef struct
+{
+  pp_shm_hdr_t   *hdr;
+  pp_shm_block_t *blocks;
+  char           *data;
+
+  int   bench;
+  int   stale;
+
+  u64   recs;
+  u64   bytes;
+  u64   blocks_cnt;
+
+} consumer_t;
+
+static const char *USAGE[] =
+{
+  "Usage: %s [options] NAME",
+  "",
+  "  -b,  --benchmark           Do not print candidates, report the consume rate",
+  "  -t,  --threads=NUM         Number of consumer threads (implies --benchmark)",
+  "  -h,  --help                Print help",
+  "",
+  NULL
+};
+
+static void usage_print (const char *progname)
+{
+  for (int i = 0; USAGE[i] != NULL; i++)
+  {
+    printf (USAGE[i], progname);
+
+    putchar ('\n');
+  }
+}
+
+static int producer_gone (const pp_shm_hdr_t *hdr)
+{
+  // a crashed producer never sets done, its ring would be waited on forever
+
+  if (__atomic_load_n (&hdr->done, __ATOMIC_ACQUIRE)) return 0;
+
+  return (kill ((pid_t) hdr->pid, 0) == -1) && (errno == ESRCH) && (__atomic_load_n (&hdr->done, __ATOMIC_ACQUIRE) == 0);
+}
+
+static void wait_seq (const u64 *seq, const u64 val, const pp_shm_hdr_t *hdr, const u64 block_seq, int *eof, int *stale)
+{
+  for (int spins = 0; __atomic_load_n (seq, __ATOMIC_ACQUIRE) != val; spins++)
+  {
+    // producer is done and will never publish this block
+
+    if (__atomic_load_n (&hdr->done, __ATOMIC_ACQUIRE))
+    {
+      if (__atomic_load_n (&hdr->head, __ATOMIC_ACQUIRE) <= block_seq)
+      {
+        *eof = 1;
+
+        return;
+      }
+    }
+
+    if (spins < 100)
+    {
+      sched_yield ();
+    }
+    else
+    {
+      const struct timespec ts = { 0, 50000 };
+
+      nanosleep (&ts, NULL);
+
+      if (((spins % 1000) == 0) && producer_gone (hdr))
+      {
+        *eof   = 1;
+        *stale = 1;
+
+        return;
+      }
+    }
+  }
+}
+
+static void *consume (void *p)
+{
+  consumer_t *consumer = (consumer_t *) p;
+
+  pp_shm_hdr_t *hdr = consumer->hdr;
+
+  const u32 blocks_cnt = hdr->blocks_cnt;
+  const u32 block_recs = hdr->block_recs;
+
+  char out_buf[BUFSIZ];
+  int  out_len = 0;
+
+  while (1)
+  {
+    const u64 block_seq = __atomic_fetch_add (&hdr->claim, 1, __ATOMIC_ACQ_REL);
+
+    pp_shm_block_t *block = &consumer->blocks[block_seq % blocks_cnt];
+
+    int eof = 0;
+
+    wait_seq (&block->ready_seq, block_seq + 1, hdr, block_seq, &eof, &consumer->stale);
+
+    if (eof) break;
+
+    const pw_t *pws = (const pw_t *) (consumer->data + (block_seq % blocks_cnt) * block_recs * sizeof (pw_t));
+
+    const u32 cnt = block->cnt;
+
+    if (consumer->bench)
+    {
+      u64 bytes = 0;
+
+      for (u32 i = 0; i < cnt; i++)
+      {
+        bytes += pws[i].pw_len;
+      }
+
+      consumer->bytes += bytes;
+    }
+    else
+    {
+      for (u32 i = 0; i < cnt; i++)
+      {
+        const u32 pw_len = pws[i].pw_len;
+
+        if (out_len + pw_len + 1 > sizeof (out_buf))
+        {
+          fwrite (out_buf, 1, out_len, stdout);
+
+          out_len = 0;
+        }
+
+        memcpy (out_buf + out_len, pws[i].i, pw_len);
+
+        out_len += pw_len;
+
+        out_buf[out_len++] = '\n';
+      }
+    }
+
+    consumer->recs += cnt;
+    consumer->blocks_cnt++;
+
+    __atomic_store_n (&block->free_seq, block_seq + blocks_cnt, __ATOMIC_RELEASE);
+  }
+
+  if (out_len) fwrite (out_buf, 1, out_len, stdout);
+
+  return NULL;
+}
+
+int main (int argc, char *argv[])
+{
+  int bench       = 0;
+  int threads_cnt = 1;
+
+  struct option long_options[] =
+  {
+    {"benchmark", no_argument,       0, 'b'},
+    {"threads",   required_argument, 0, 't'},
+    {"help",      no_argument,       0, 'h'},
+    {0, 0, 0, 0}
+  };
+
+  int option_index = 0;
+
+  int c;
+
+  while ((c = getopt_long (argc, argv, "bt:h", long_options, &option_index)) != -1)
+  {
+    switch (c)
+    {
+      case 'b': bench       = 1;              break;
+      case 't': threads_cnt = atoi (optarg);
+                bench       = 1;              break;
+      case 'h': usage_print (argv[0]);        return (-1);
+
+      default: return (-1);
+    }
+  }
+
+  if (optind + 1 != argc)
+  {
+    usage_print (argv[0]);
+
+    return (-1);
+  }
+
+  if ((threads_cnt < 1) || (threads_cnt > CONSUMERS_MAX))
+  {
+    fprintf (stderr, "Value of --threads (%d) must be between 1 and %d\n", threads_cnt, CONSUMERS_MAX);
+
+    return (-1);
+  }
+
+  const char *name = argv[optind];
+
+  // pp may not have created the ring yet
+
+  int fd = -1;
+
+  struct stat st;
+
+  while (1)
+  {
+    fd = shm_open (name, O_RDWR, 0);
+
+    if ((fd != -1) && (fstat (fd, &st) == 0) && (st.st_size >= PP_SHM_PAGE)) break;
+
+    if (fd != -1) close (fd);
+
+    usleep (10000);
+  }
+
+  pp_shm_hdr_t *hdr = mmap (NULL, PP_SHM_PAGE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  if (hdr == MAP_FAILED)
+  {
+    fprintf (stderr, "mmap: %s\n", strerror (errno));
+
+    return (-1);
+  }
+
+  while (__atomic_load_n (&hdr->magic, __ATOMIC_ACQUIRE) != PP_SHM_MAGIC) usleep (1000);
+
+  if ((hdr->version != PP_SHM_VERSION) || (hdr->rec_size != sizeof (pw_t)))
+  {
+    fprintf (stderr, "%s: unsupported ring version %u\n", name, hdr->version);
+
+    return (-1);
+  }
+
+  if (producer_gone (hdr))
+  {
+    fprintf (stderr, "%s: stale ring, producer %u is gone\n", name, hdr->pid);
+
+    return (-1);
+  }
+
+  const u64 shm_size = pp_shm_size (hdr->blocks_cnt, hdr->block_recs);
+
+  munmap (hdr, PP_SHM_PAGE);
+
+  char *ptr = mmap (NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  if (ptr == MAP_FAILED)
+  {
+    fprintf (stderr, "mmap: %s\n", strerror (errno));
+
+    return (-1);
+  }
+
+  hdr = (pp_shm_hdr_t *) ptr;
+
+  consumer_t consumers[CONSUMERS_MAX];
+
+  pthread_t threads[CONSUMERS_MAX];
+
+  struct timespec ts_beg;
+  struct timespec ts_end;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts_beg);
+
+  for (int i = 0; i < threads_cnt; i++)
+  {
+    consumer_t *consumer = &consumers[i];
+
+    memset (consumer, 0, sizeof (consumer_t));
+
+    consumer->hdr    = hdr;
+    consumer->blocks = (pp_shm_block_t *) (ptr + pp_shm_blocks_off ());
+    consumer->data   = ptr + pp_shm_data_off (hdr->blocks_cnt);
+    consumer->bench  = bench;
+
+    pthread_create (&threads[i], NULL, consume, consumer);
+  }
+
+  u64 recs  = 0;
+  u64 bytes = 0;
+
+  int stale = 0;
+
+  for (int i = 0; i < threads_cnt; i++)
+  {
+    pthread_join (threads[i], NULL);
+
+    recs  += consumers[i].recs;
+    bytes += consumers[i].bytes;
+    stale |= consumers[i].stale;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &ts_end);
+
+  if (bench)
+  {
+    const double secs = (ts_end.tv_sec - ts_beg.tv_sec) + (ts_end.tv_nsec - ts_beg.tv_nsec) / 1e9;
+
+    fprintf (stderr, "%llu candidates (%llu bytes) in %.3f s, %.2f M/s with %d consumer(s)\n",
+      (unsigned long long) recs, (unsigned long long) bytes, secs, (secs > 0) ? recs / secs / 1e6 : 0, threads_cnt);
+  }
+
+  if (stale)
+  {
+    fprintf (stderr, "%s: producer %u is gone, output is incomplete\n", name, hdr->pid);
+  }
+
+  munmap (ptr, shm_size);
+
+  close (fd);
+
+  return (stale) ? -1 : 0;
+}